@@ -0,0 +1,248 @@
+#pragma once
+
+// ===== Поток боевых событий =====
+// Общий для лабораторных 1.1 и 1.3: подключается через #include "../common/combat_events.h".
+// Боевые методы не печатают сами: они дописывают короткие события в буфер своего потока.
+// Подписчики (вывод на консоль, журнал, статистика) получают события пачками — при заполнении
+// буфера, при CombatEvents::flush() и при завершении потока. Без подписчиков события не пишутся.
+// Участники записаны идентификаторами из словаря имён, поэтому событие переживает сами сущности.
+// Подписчики вызываются без блокировки шины: из onEvents можно подписываться и отписываться.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "name_table.h"
+
+enum class CombatEventType : uint8_t { Hit, Miss, Heal, Damage, Crit };
+
+struct CombatEvent {
+    CombatEventType type;
+    int amount;      // урон или лечение
+    int healthAfter; // здоровье цели после события
+    NameTable::Id actor;
+    NameTable::Id target;
+    const char* detail; // текст особой атаки для Crit (строка со статическим временем жизни)
+};
+
+// onEvents может вызываться из нескольких потоков одновременно (каждый сбрасывает свой буфер),
+// поэтому подписчик с общим состоянием защищает его сам
+class CombatSubscriber {
+public:
+    virtual ~CombatSubscriber() {}
+    virtual void onEvents(const CombatEvent* events, size_t count) = 0;
+};
+
+class CombatEvents {
+public:
+    static void subscribe(CombatSubscriber* subscriber) {
+        CombatEvents& bus = instance();
+        std::lock_guard<std::mutex> lock(bus.mtx);
+        bus.subscribers.push_back(subscriber);
+        bus.subscriberCount.store(bus.subscribers.size(), std::memory_order_relaxed);
+    }
+
+    // После возврата подписчик больше не вызывается, и его можно удалять: отписка ждёт
+    // только рассылки, начатые до неё (у них ещё может быть копия списка с этим подписчиком).
+    // Рассылки, начатые позже, его уже не видят, поэтому поток непрерывных событий отписку
+    // не задерживает. Из onEvents отписка не ждёт (иначе два потока могли бы ждать друг друга);
+    // своя рассылка пропускает отписанных сама.
+    static void unsubscribe(CombatSubscriber* subscriber) {
+        CombatEvents& bus = instance();
+        std::unique_lock<std::mutex> lock(bus.mtx);
+        bus.subscribers.erase(std::remove(bus.subscribers.begin(), bus.subscribers.end(), subscriber),
+                              bus.subscribers.end());
+        bus.subscriberCount.store(bus.subscribers.size(), std::memory_order_relaxed);
+        bus.version.fetch_add(1, std::memory_order_release);
+        if (dispatchDepth() == 0) {
+            uint64_t removedAt = bus.nextTicket;
+            bus.idle.wait(lock, [&bus, removedAt] {
+                return std::none_of(bus.running.begin(), bus.running.end(),
+                                    [removedAt](uint64_t ticket) { return ticket < removedAt; });
+            });
+        }
+    }
+
+    static bool active() { return instance().subscriberCount.load(std::memory_order_relaxed) > 0; }
+
+    static void emit(CombatEventType type, int amount, int healthAfter, NameTable::Id actor, NameTable::Id target,
+                     const char* detail = nullptr) {
+        if (!active()) return;
+        localBuffer().push(CombatEvent{type, amount, healthAfter, actor, target, detail});
+    }
+
+    // Отдать подписчикам накопленные события текущего потока
+    static void flush() { localBuffer().flush(); }
+
+private:
+    static constexpr size_t kBufferSize = 256;
+
+    // Рассылка текущего потока: её номер остаётся в running до выхода, в том числе по исключению
+    struct DispatchScope {
+        CombatEvents& bus;
+        uint64_t ticket;
+
+        DispatchScope(CombatEvents& bus, uint64_t ticket) : bus(bus), ticket(ticket) { ++dispatchDepth(); }
+
+        ~DispatchScope() {
+            --dispatchDepth();
+            {
+                std::lock_guard<std::mutex> lock(bus.mtx);
+                auto it = std::find(bus.running.begin(), bus.running.end(), ticket);
+                *it = bus.running.back();
+                bus.running.pop_back();
+            }
+            bus.idle.notify_all();
+        }
+    };
+
+    struct Buffer {
+        CombatEvent events[kBufferSize];
+        size_t size = 0;
+
+        void push(const CombatEvent& event) {
+            events[size++] = event;
+            if (size == kBufferSize) flush();
+        }
+
+        // Список подписчиков копируется под блокировкой, а вызываются они уже без неё
+        void flush() {
+            if (size == 0) return;
+            CombatEvents& bus = instance();
+            std::vector<CombatSubscriber*> targets;
+            uint64_t seen;
+            uint64_t ticket;
+            {
+                std::lock_guard<std::mutex> lock(bus.mtx);
+                targets = bus.subscribers;
+                seen = bus.version.load(std::memory_order_relaxed);
+                ticket = bus.nextTicket++;
+                bus.running.push_back(ticket);
+            }
+            {
+                DispatchScope scope(bus, ticket);
+                for (CombatSubscriber* subscriber : targets) {
+                    // Кто-то отписался во время рассылки: отписанным события уже не отдаются
+                    if (bus.version.load(std::memory_order_acquire) != seen && !bus.isSubscribed(subscriber)) continue;
+                    subscriber->onEvents(events, size);
+                }
+            }
+            size = 0;
+        }
+
+        ~Buffer() { flush(); }
+    };
+
+    static CombatEvents& instance() {
+        static CombatEvents bus;
+        return bus;
+    }
+
+    static Buffer& localBuffer() {
+        thread_local Buffer buffer;
+        return buffer;
+    }
+
+    // Сколько рассылок текущего потока сейчас идёт (больше нуля — мы внутри onEvents)
+    static size_t& dispatchDepth() {
+        thread_local size_t depth = 0;
+        return depth;
+    }
+
+    bool isSubscribed(CombatSubscriber* subscriber) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return std::find(subscribers.begin(), subscribers.end(), subscriber) != subscribers.end();
+    }
+
+    std::mutex mtx;
+    std::condition_variable idle; // завершилась чья-то рассылка
+    std::vector<CombatSubscriber*> subscribers;
+    std::atomic<size_t> subscriberCount{0};
+    std::atomic<uint64_t> version{0}; // растёт при каждой отписке
+    uint64_t nextTicket = 0;          // номер следующей рассылки (под mtx)
+    std::vector<uint64_t> running;    // номера идущих рассылок всех потоков (под mtx)
+};
+
+// Текстовый вывод событий в поток (консоль или файл журнала)
+class CombatRenderer : public CombatSubscriber {
+public:
+    explicit CombatRenderer(std::ostream& out) : out(out) { CombatEvents::subscribe(this); }
+    ~CombatRenderer() { CombatEvents::unsubscribe(this); }
+
+    void onEvents(const CombatEvent* events, size_t count) override {
+        std::lock_guard<std::mutex> lock(mtx); // пачки разных потоков не перемешиваются
+        NameTable& names = NameTable::instance();
+        for (size_t i = 0; i < count; ++i) {
+            const CombatEvent& e = events[i];
+            std::string_view actor = names.view(e.actor);
+            switch (e.type) {
+            case CombatEventType::Hit:
+                out << actor << " attacks " << names.view(e.target) << " for " << e.amount << " damage!\n";
+                break;
+            case CombatEventType::Miss:
+                out << actor << " attacks " << names.view(e.target) << ", but it has no effect!\n";
+                break;
+            case CombatEventType::Heal:
+                out << actor << " healed for " << e.amount << " HP. Current HP: " << e.healthAfter << "\n";
+                break;
+            case CombatEventType::Damage:
+                out << actor << " took " << e.amount << " damage. Current HP: " << e.healthAfter << "\n";
+                break;
+            case CombatEventType::Crit:
+                out << e.detail;
+                break;
+            }
+        }
+        out.flush();
+    }
+
+private:
+    std::ostream& out;
+    std::mutex mtx;
+};
+
+// Счётчики событий по типам
+class CombatStats : public CombatSubscriber {
+public:
+    CombatStats() { CombatEvents::subscribe(this); }
+    ~CombatStats() { CombatEvents::unsubscribe(this); }
+
+    void onEvents(const CombatEvent* events, size_t count) override {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (size_t i = 0; i < count; ++i) {
+            ++counts[static_cast<size_t>(events[i].type)];
+            if (events[i].type == CombatEventType::Heal) {
+                healed += events[i].amount;
+            } else if (events[i].type == CombatEventType::Hit || events[i].type == CombatEventType::Damage) {
+                dealt += events[i].amount;
+            }
+        }
+    }
+
+    long long count(CombatEventType type) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return counts[static_cast<size_t>(type)];
+    }
+
+    long long totalDealt() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return dealt;
+    }
+
+    long long totalHealed() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return healed;
+    }
+
+private:
+    mutable std::mutex mtx;
+    long long counts[5] = {};
+    long long dealt = 0;
+    long long healed = 0;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+// ===== Генератор случайных чисел для игровых лабораторных =====
+// Общий для лабораторных 1.3 и 7.2: подключается через #include "../common/game_rng.h".
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+// Быстрый генератор PCG32 (XSH-RR): 16 байт состояния,
+// независимые потоки чисел выбираются параметром stream
+class GameRng {
+private:
+    uint64_t state = 0;
+    uint64_t inc = 1;
+
+public:
+    GameRng(uint64_t seed, uint64_t stream) : inc((stream << 1u) | 1u) {
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    // Равномерное число в [0, bound) без смещения (метод Лемира); bound должен быть больше нуля
+    uint32_t bounded(uint32_t bound) {
+        if (bound == 0) {
+            throw std::invalid_argument("GameRng::bounded: empty range");
+        }
+        uint64_t m = static_cast<uint64_t>(next()) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < bound) {
+            uint32_t threshold = (0u - bound) % bound;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(next()) * bound;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    // Равномерное число в [lo, hi]; при hi < lo — исключение
+    int range(int lo, int hi) {
+        if (hi < lo) {
+            throw std::invalid_argument("GameRng::range: hi < lo");
+        }
+        uint32_t span = static_cast<uint32_t>(static_cast<int64_t>(hi) - lo) + 1u;
+        uint32_t offset = span == 0 ? next() : bounded(span); // span == 0: весь диапазон int
+        return static_cast<int>(static_cast<int64_t>(lo) + offset);
+    }
+
+    // Срабатывание с вероятностью percent %
+    bool chance(uint32_t percent) {
+        return bounded(100) < percent;
+    }
+};
+
+// Главное зерно: все потоки чисел выводятся из него, поэтому бой воспроизводим
+inline uint64_t rngMasterSeed = 0;
+inline std::atomic<uint64_t> rngNextStream{0};
+
+inline void setMasterSeed(uint64_t seed) {
+    rngMasterSeed = seed;
+    rngNextStream = 0;
+}
+
+// Перемешивание SplitMix64, чтобы близкие зерна давали несвязанные состояния
+inline uint64_t splitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Новый независимый поток чисел (по одному на генератор или сущность)
+inline GameRng makeRngStream() {
+    uint64_t stream = rngNextStream++;
+    return GameRng(splitMix64(rngMasterSeed ^ splitMix64(stream)), stream);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+// ===== Учёт времени жизни объектов =====
+// Общий для игровых лабораторных: подключается через #include "../common/lifetime.h",
+// а в закрытую часть класса ставится LIFETIME_TRACKED(Имя класса).
+// По умолчанию учёт выключен и не оставляет в программе ничего. Сборка с
+// -DLIFETIME_TRACKING=1 включает счётчики и отчёт об утечках при выходе (в stderr);
+// -DLIFETIME_ALLOC_ACCOUNTING=1 добавляет подсчёт байт (sizeof живых объектов
+// и выделений через new для класса).
+#ifndef LIFETIME_TRACKING
+#define LIFETIME_TRACKING 0
+#endif
+#ifndef LIFETIME_ALLOC_ACCOUNTING
+#define LIFETIME_ALLOC_ACCOUNTING 0
+#endif
+
+#if LIFETIME_TRACKING
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace lifetime {
+
+// Счётчики одного типа. Все операции relaxed: нужны только итоговые значения,
+// порядок относительно других данных не важен.
+struct Counters {
+    const char* type;
+    std::atomic<long> live{0};
+    std::atomic<long> peak{0};
+    std::atomic<long> total{0};
+    std::atomic<long> bytesLive{0};
+    std::atomic<long> bytesPeak{0};
+    std::atomic<long> heapAllocs{0};
+    std::atomic<long> heapBytesLive{0};
+    Counters* next = nullptr;
+
+    explicit Counters(const char* t);
+
+    static void raisePeak(std::atomic<long>& peakValue, long value) {
+        long seen = peakValue.load(std::memory_order_relaxed);
+        while (value > seen && !peakValue.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onCreate(size_t size) {
+        total.fetch_add(1, std::memory_order_relaxed);
+        raisePeak(peak, live.fetch_add(1, std::memory_order_relaxed) + 1);
+#if LIFETIME_ALLOC_ACCOUNTING
+        long bytes = static_cast<long>(size);
+        raisePeak(bytesPeak, bytesLive.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+#else
+        (void)size;
+#endif
+    }
+
+    void onDestroy(size_t size) {
+        live.fetch_sub(1, std::memory_order_relaxed);
+#if LIFETIME_ALLOC_ACCOUNTING
+        bytesLive.fetch_sub(static_cast<long>(size), std::memory_order_relaxed);
+#else
+        (void)size;
+#endif
+    }
+};
+
+// Список всех учитываемых типов; дополняется без блокировок при первом объекте типа
+inline std::atomic<Counters*>& registryHead() {
+    static std::atomic<Counters*> head{nullptr};
+    return head;
+}
+
+inline void report() {
+    std::fprintf(stderr, "\n=== Lifetime report ===\n");
+    std::fprintf(stderr, "%-12s %10s %10s %10s", "type", "total", "peak", "live");
+#if LIFETIME_ALLOC_ACCOUNTING
+    std::fprintf(stderr, " %12s %12s %10s %12s", "bytes live", "bytes peak", "heap new", "heap live");
+#endif
+    std::fprintf(stderr, "\n");
+    for (Counters* c = registryHead().load(std::memory_order_acquire); c; c = c->next) {
+        long live = c->live.load(std::memory_order_relaxed);
+        std::fprintf(stderr, "%-12s %10ld %10ld %10ld", c->type, c->total.load(std::memory_order_relaxed),
+                     c->peak.load(std::memory_order_relaxed), live);
+#if LIFETIME_ALLOC_ACCOUNTING
+        std::fprintf(stderr, " %12ld %12ld %10ld %12ld", c->bytesLive.load(std::memory_order_relaxed),
+                     c->bytesPeak.load(std::memory_order_relaxed), c->heapAllocs.load(std::memory_order_relaxed),
+                     c->heapBytesLive.load(std::memory_order_relaxed));
+#endif
+        std::fprintf(stderr, "%s\n", live != 0 ? "  <- LEAK" : "");
+    }
+}
+
+inline Counters::Counters(const char* t) : type(t) {
+    // Отчёт регистрируется вместе с первым типом и печатается при выходе
+    static const bool reportRegistered = (std::atexit(report), true);
+    (void)reportRegistered;
+    std::atomic<Counters*>& head = registryHead();
+    next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+}
+
+template <typename T>
+Counters& countersFor(const char* type) {
+    static Counters counters(type);
+    return counters;
+}
+
+// Поле-метка внутри учитываемого класса: копирование и перемещение владельца
+// считаются новым объектом, присваивание ничего не меняет
+template <typename T>
+class Tracked {
+public:
+    Tracked(const char* type, size_t size) : counters(&countersFor<T>(type)), size(size) { counters->onCreate(size); }
+    Tracked(const Tracked& other) : counters(other.counters), size(other.size) { counters->onCreate(size); }
+    Tracked& operator=(const Tracked&) { return *this; }
+    ~Tracked() { counters->onDestroy(size); }
+
+private:
+    Counters* counters;
+    size_t size;
+};
+
+}  // namespace lifetime
+
+#if LIFETIME_ALLOC_ACCOUNTING
+// GCC 11+ после встраивания считает пару operator new/delete класса несовпадающей
+// (ложное -Wmismatched-new-delete); в этом режиме предупреждение отключается
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+#define LIFETIME_HEAP_HOOKS(Type)                                                                  \
+public:                                                                                            \
+    static void* operator new(size_t n) {                                                          \
+        auto& c = ::lifetime::countersFor<Type>(#Type);                                            \
+        c.heapAllocs.fetch_add(1, std::memory_order_relaxed);                                      \
+        c.heapBytesLive.fetch_add(static_cast<long>(n), std::memory_order_relaxed);                \
+        return ::operator new(n);                                                                  \
+    }                                                                                              \
+    static void operator delete(void* p, size_t n) {                                               \
+        ::lifetime::countersFor<Type>(#Type).heapBytesLive.fetch_sub(static_cast<long>(n),         \
+                                                                     std::memory_order_relaxed);   \
+        ::operator delete(p, n);                                                                   \
+    }                                                                                              \
+    static void* operator new(size_t, void* place) noexcept { return place; }                      \
+    static void operator delete(void*, void*) noexcept {}                                          \
+private:
+#else
+#define LIFETIME_HEAP_HOOKS(Type)
+#endif
+
+// Ставится в закрытую часть класса (после него действует private:);
+// открытый интерфейс класса не меняется
+#define LIFETIME_TRACKED(Type) \
+    ::lifetime::Tracked<Type> lifetimeTracker{#Type, sizeof(Type)}; \
+    LIFETIME_HEAP_HOOKS(Type)
+#else
+#define LIFETIME_TRACKED(Type)
+#endif
@@ -0,0 +1,348 @@
+#pragma once
+
+// ===== Сжатые кадры =====
+// Общий для лабораторных 7.1 (сжатое сохранение) и 9 (сжатый журнал и сохранение):
+// подключается через #include "../common/lz_frames.h". Файлы обеих лабораторных устроены
+// одинаково, поэтому одна сигнатура "GMLZ" означает один формат.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ===== Сжатие блоков =====
+// Кодек семейства LZ77 в формате блоков LZ4. Последовательность: байт-токен (старшие 4 бита —
+// число литералов, младшие — длина совпадения минус kMinMatch), продолжение числа литералов,
+// литералы, смещение совпадения (2 байта, little-endian) и продолжение длины совпадения.
+// Продолжение — байты по 255 и последний меньше 255; значение 15 в токене означает, что оно есть.
+// Последняя последовательность блока — только литералы. Словарь — сам блок, поэтому блоки
+// сжимаются и распаковываются независимо друг от друга.
+namespace lz {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;  // последние байты блока всегда идут литералами
+constexpr size_t kMatchLimit = 12;   // совпадение не начинается ближе к концу блока
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 14;
+
+inline uint32_t load32(const char* at) {
+    uint32_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+inline uint64_t load64(const char* at) {
+    uint64_t value;
+    std::memcpy(&value, at, sizeof(value));
+    return value;
+}
+
+// Число совпадающих байт a и b, не дальше end; сравнение по 8 байт
+inline size_t commonLength(const char* a, const char* b, const char* end) {
+    const char* start = a;
+    while (a + 8 <= end) {
+        uint64_t diff = load64(a) ^ load64(b);
+        if (diff != 0) {
+#if defined(__GNUC__)
+            return static_cast<size_t>(a - start) + static_cast<size_t>(__builtin_ctzll(diff) / 8);
+#else
+            while (*a == *b) ++a, ++b;
+            return static_cast<size_t>(a - start);
+#endif
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < end && *a == *b) ++a, ++b;
+    return static_cast<size_t>(a - start);
+}
+
+inline uint32_t hash4(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+inline char* putLength(char* out, size_t length) {
+    for (length -= 15; length >= 255; length -= 255) *out++ = static_cast<char>(255);
+    *out++ = static_cast<char>(length);
+    return out;
+}
+
+inline char* putSequence(char* out, const char* literals, size_t literalCount, size_t offset, size_t matchLength) {
+    size_t extra = matchLength - kMinMatch;
+    *out++ = static_cast<char>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(extra, 15));
+    if (literalCount >= 15) out = putLength(out, literalCount);
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+    *out++ = static_cast<char>(offset & 0xFF);
+    *out++ = static_cast<char>(offset >> 8);
+    if (extra >= 15) out = putLength(out, extra);
+    return out;
+}
+
+// Сжатие src в конец out. table — рабочая таблица хешей, переиспользуется между блоками.
+// После серии промахов шаг поиска растёт, так что несжимаемые данные проходятся быстро.
+inline void compress(std::string_view src, std::string& out, std::vector<uint32_t>& table) {
+    table.assign(size_t(1) << kHashBits, 0);
+    size_t start = out.size();
+    out.resize(start + src.size() + src.size() / 255 + 16);  // худший случай: всё литералами
+    char* to = out.data() + start;
+    const char* base = src.data();
+    size_t anchor = 0;
+    if (src.size() > kMatchLimit) {
+        size_t limit = src.size() - kMatchLimit;
+        size_t matchEnd = src.size() - kLastLiterals;
+        size_t pos = 1;
+        unsigned misses = 0;
+        while (pos < limit) {
+            uint32_t sequence = load32(base + pos);
+            uint32_t& slot = table[hash4(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos);
+            if (candidate >= pos || pos - candidate > kMaxOffset || load32(base + candidate) != sequence) {
+                pos += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+            while (pos > anchor && candidate > 0 && base[pos - 1] == base[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+            size_t length = kMinMatch + commonLength(base + pos + kMinMatch, base + candidate + kMinMatch, base + matchEnd);
+            to = putSequence(to, base + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+            if (pos < limit) table[hash4(load32(base + pos - 2))] = static_cast<uint32_t>(pos - 2);
+        }
+    }
+    size_t literalCount = src.size() - anchor;
+    *to++ = static_cast<char>(std::min<size_t>(literalCount, 15) << 4);
+    if (literalCount >= 15) to = putLength(to, literalCount);
+    std::memcpy(to, base + anchor, literalCount);
+    to += literalCount;
+    out.resize(static_cast<size_t>(to - out.data()));
+}
+
+// Распаковка src ровно в size байт по адресу dst; любое нарушение формата — исключение
+inline void decompress(std::string_view src, char* dst, size_t size) {
+    auto fail = [] { throw std::runtime_error("Corrupted compressed block"); };
+    size_t in = 0;
+    size_t out = 0;
+    auto length = [&](size_t value) {
+        if (value == 15) {
+            uint8_t next;
+            do {
+                if (in >= src.size()) fail();
+                next = static_cast<uint8_t>(src[in++]);
+                value += next;
+            } while (next == 255);
+        }
+        return value;
+    };
+    while (true) {
+        if (in >= src.size()) fail();
+        uint8_t token = static_cast<uint8_t>(src[in++]);
+        size_t literalCount = length(token >> 4);
+        if (literalCount > src.size() - in || literalCount > size - out) fail();
+        if (literalCount <= 16 && src.size() - in >= 16 && size - out >= 16) {
+            std::memcpy(dst + out, src.data() + in, 16);  // короткие литералы одной копией с запасом
+        } else {
+            std::memcpy(dst + out, src.data() + in, literalCount);
+        }
+        in += literalCount;
+        out += literalCount;
+        if (in == src.size()) break;
+
+        if (src.size() - in < 2) fail();
+        size_t offset = static_cast<uint8_t>(src[in]) | static_cast<size_t>(static_cast<uint8_t>(src[in + 1])) << 8;
+        in += 2;
+        size_t matchLength = length(token & 15) + kMinMatch;
+        if (offset == 0 || offset > out || matchLength > size - out) fail();
+        char* to = dst + out;
+        const char* from = to - offset;
+        if (offset >= 8 && size - out >= matchLength + 8) {
+            // Куски по 8 байт не перекрываются при смещении от 8; хвост последнего куска перезапишется
+            for (size_t i = 0; i < matchLength; i += 8) std::memcpy(to + i, from + i, 8);
+        } else {
+            for (size_t i = 0; i < matchLength; ++i) to[i] = from[i];
+        }
+        out += matchLength;
+    }
+    if (out != size) fail();
+}
+
+}  // namespace lz
+
+// ===== Сжатый файл =====
+// Заголовок: "GMLZ" и версия (varint). Дальше кадры: число строк, размер исходного текста и
+// размер сжатых данных (varint), данные и CRC32 исходного текста (4 байта, little-endian).
+// Кадр содержит целые строки и распаковывается отдельно от остальных; если сжатие не выигрывает,
+// текст хранится как есть (оба размера равны). Кадр без строк завершает файл.
+// Сохранение без завершающего кадра считается обрезанным. Журнал пишется кадрами по мере игры:
+// перед дозаписью с него срезаются завершающий кадр и оборванный хвост, а если программа упала,
+// не закрыв журнал, оборванный последний кадр при чтении пропускается.
+namespace lzfile {
+
+constexpr char kMagic[4] = {'G', 'M', 'L', 'Z'};
+constexpr uint64_t kVersion = 1;
+constexpr size_t kHeaderBytes = sizeof(kMagic) + 1; // версия меньше 0x80 занимает один байт
+constexpr size_t kFrameBytes = 256 * 1024;          // кадр закрывается, когда текста набирается больше
+
+// CRC-32 (IEEE), по 8 байт за шаг (slicing-by-8)
+inline uint32_t crc32(std::string_view data) {
+    static const auto tables = [] {
+        std::array<std::array<uint32_t, 256>, 8> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < 8; ++k) t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+        }
+        return t;
+    }();
+    auto byteAt = [&data](size_t i) { return static_cast<uint32_t>(static_cast<uint8_t>(data[i])); };
+    uint32_t crc = 0xFFFFFFFFu;
+    size_t i = 0;
+    for (; i + 8 <= data.size(); i += 8) {
+        uint32_t low = crc ^ (byteAt(i) | byteAt(i + 1) << 8 | byteAt(i + 2) << 16 | byteAt(i + 3) << 24);
+        uint32_t high = byteAt(i + 4) | byteAt(i + 5) << 8 | byteAt(i + 6) << 16 | byteAt(i + 7) << 24;
+        crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^
+              tables[4][low >> 24] ^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+              tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+    }
+    for (; i < data.size(); ++i) crc = tables[0][(crc ^ byteAt(i)) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline void putFixed32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+}
+
+// Заголовок на месте: сигнатура и поддерживаемая версия
+inline bool hasHeader(std::string_view data) {
+    return data.size() >= kHeaderBytes && data.compare(0, sizeof(kMagic), std::string_view(kMagic, sizeof(kMagic))) == 0 &&
+           data[sizeof(kMagic)] >= 1 && static_cast<uint64_t>(data[sizeof(kMagic)]) <= kVersion;
+}
+
+inline void writeHeader(std::ostream& out) {
+    std::string header(kMagic, sizeof(kMagic));
+    putVarint(header, kVersion);
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+// Кадр из text (lines строк) в поток; packed и table — рабочие буферы вызывающего,
+// чтобы кадры подряд не выделяли память заново
+inline void writeFrame(std::ostream& out, std::string_view text, uint64_t lines, std::string& packed,
+                       std::vector<uint32_t>& table) {
+    packed.clear();
+    if (!text.empty()) lz::compress(text, packed, table);
+    std::string_view data = packed.size() < text.size() ? std::string_view(packed) : text;
+    std::string frame;
+    putVarint(frame, lines);
+    putVarint(frame, text.size());
+    putVarint(frame, data.size());
+    out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    frame.clear();
+    putFixed32(frame, crc32(text));
+    out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+}
+
+inline void writeFrame(std::ostream& out, std::string_view text, uint64_t lines) {
+    static thread_local std::string packed;
+    static thread_local std::vector<uint32_t> table;
+    writeFrame(out, text, lines, packed, table);
+}
+
+// Завершающий кадр: ни строк, ни данных
+inline void writeEndFrame(std::ostream& out) { writeFrame(out, std::string_view(), 0); }
+
+struct Frame {
+    uint64_t lines = 0;
+    size_t size = 0;
+    std::string_view data;
+    uint32_t crc = 0;
+};
+
+// Кадр в начале data без распаковки. Возвращает его длину в байтах или 0, если data
+// кончается посреди кадра; неверные размеры — std::runtime_error
+inline size_t parseFrame(std::string_view data, Frame& frame) {
+    size_t pos = 0;
+    auto varint = [&](uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == data.size()) return false;
+            uint8_t byte = static_cast<uint8_t>(data[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        throw std::runtime_error("Invalid varint in compressed frame");
+    };
+    uint64_t size = 0;
+    uint64_t packed = 0;
+    if (!varint(frame.lines) || !varint(size) || !varint(packed)) return 0;
+    // Одна последовательность кодека разворачивается не больше чем в ~255 раз
+    if (packed > size || size > packed * 255 + 16) {
+        throw std::runtime_error("Invalid compressed frame size");
+    }
+    if (packed + 4 > data.size() - pos) return 0;
+    frame.size = static_cast<size_t>(size);
+    frame.data = data.substr(pos, static_cast<size_t>(packed));
+    pos += static_cast<size_t>(packed);
+    frame.crc = 0;
+    for (int i = 0; i < 4; ++i) frame.crc |= static_cast<uint32_t>(static_cast<uint8_t>(data[pos++])) << (8 * i);
+    return pos;
+}
+
+// Все кадры файла без распаковки: кадры с данными до завершающего кадра или до конца файла
+struct Contents {
+    std::vector<Frame> frames;
+    size_t dataEnd = 0;    // конец последнего целого кадра с данными
+    bool finished = false; // файл закрыт завершающим кадром
+};
+
+inline Contents readContents(std::string_view file) {
+    if (!hasHeader(file)) {
+        throw std::runtime_error("Not a compressed file");
+    }
+    Contents contents;
+    contents.dataEnd = kHeaderBytes;
+    Frame frame;
+    while (size_t length = parseFrame(file.substr(contents.dataEnd), frame)) {
+        if (frame.lines == 0) {
+            contents.finished = true;
+            break;
+        }
+        contents.frames.push_back(frame);
+        contents.dataEnd += length;
+    }
+    return contents;
+}
+
+// Исходный текст кадра в out (frame.size байт); ошибка CRC — std::runtime_error
+inline void unpackFrame(const Frame& frame, char* out) {
+    if (frame.data.size() == frame.size) {
+        std::memcpy(out, frame.data.data(), frame.size);
+    } else {
+        lz::decompress(frame.data, out, frame.size);
+    }
+    if (crc32(std::string_view(out, frame.size)) != frame.crc) {
+        throw std::runtime_error("Compressed frame checksum mismatch");
+    }
+}
+
+}  // namespace lzfile
@@ -0,0 +1,70 @@
+#pragma once
+
+// ===== Словарь имён =====
+// Общий для лабораторных 1.1, 1.3 и 7.2: подключается через #include "../common/name_table.h".
+// Каждое имя хранится один раз, а сущности держат его 32-битный идентификатор.
+// Запись (intern) идёт под мьютексом; чтение имени по идентификатору — без блокировок:
+// строки лежат в блоках, которые никогда не перемещаются и не освобождаются.
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class NameTable {
+public:
+    using Id = uint32_t;
+
+    static NameTable& instance() {
+        static NameTable* table = new NameTable(); // не разрушается: имена читаются до самого выхода
+        return *table;
+    }
+
+    Id intern(std::string_view name) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+
+        Id id = count;
+        size_t chunk = id >> kChunkBits;
+        if (chunk >= kMaxChunks) {
+            throw std::length_error("NameTable is full");
+        }
+        std::string* block = chunks[chunk].load(std::memory_order_relaxed);
+        if (!block) {
+            block = new std::string[kChunkSize];
+            chunks[chunk].store(block, std::memory_order_release);
+        }
+        std::string& slot = block[id & (kChunkSize - 1)];
+        slot.assign(name);
+        ids.emplace(std::string_view(slot), id);
+        ++count;
+        return id;
+    }
+
+    // Имя по идентификатору, полученному из intern(). Блокировка не берётся, поэтому
+    // действует правило: поток, читающий имя, должен получить id так, чтобы возврат из
+    // intern() произошёл раньше чтения (тот же поток, или id передан через мьютекс,
+    // очередь, запуск потока). Одновременный intern() других имён при этом безопасен:
+    // он пишет только в свободные ячейки и никогда не трогает уже выданные.
+    std::string_view view(Id id) const {
+        return chunks[id >> kChunkBits].load(std::memory_order_acquire)[id & (kChunkSize - 1)];
+    }
+
+private:
+    static constexpr size_t kChunkBits = 10;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+    static constexpr size_t kMaxChunks = 4096; // до 4M различных имён
+
+    NameTable() {
+        for (auto& chunk : chunks) chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    std::mutex writeMutex;
+    std::unordered_map<std::string_view, Id> ids;
+    Id count = 0;
+    std::atomic<std::string*> chunks[kMaxChunks];
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+// ===== Очередь на кольцевом буфере =====
+// Общая для лабораторных 5 и 6: подключается через #include "../common/ring_queue.h",
+// каждая лабораторная задаёт свой псевдоним Queue<T>.
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// Что pop() и display() делают с пустой очередью: ничего (лабораторная 5) или бросают
+// std::runtime_error (лабораторная 6). front() пустой очереди бросает исключение всегда.
+enum class OnEmptyQueue { Ignore, Throw };
+
+// Кольцевой буфер в одном массиве, ёмкость — степень двойки.
+// head и tail только растут, место элемента в массиве — индекс & (ёмкость - 1).
+// Когда места нет, массив удваивается и элементы переезжают в него по порядку.
+template <typename T, OnEmptyQueue onEmpty>
+class RingQueue {
+private:
+    std::allocator<T> allocator;
+    T* slots = nullptr;
+    size_t capacity = 0;
+    size_t head = 0; // номер первого элемента
+    size_t tail = 0; // номер следующего за последним
+
+    T* slot(size_t index) const { return slots + (index & (capacity - 1)); }
+
+    // Элементы по порядку в начало newSlots; при исключении перенесённые уничтожаются
+    void moveTo(T* newSlots) {
+        size_t moved = 0;
+        try {
+            for (; moved < size(); ++moved) {
+                ::new (static_cast<void*>(newSlots + moved)) T(std::move_if_noexcept(*slot(head + moved)));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < moved; ++i) newSlots[i].~T();
+            throw;
+        }
+    }
+
+    // Старый массив освобождается, очередь переходит на newSlots с count элементами
+    void adopt(T* newSlots, size_t newCapacity, size_t count) {
+        release();
+        slots = newSlots;
+        capacity = newCapacity;
+        head = 0;
+        tail = count;
+    }
+
+    void reallocate(size_t newCapacity) {
+        T* newSlots = allocator.allocate(newCapacity);
+        try {
+            moveTo(newSlots);
+        } catch (...) {
+            allocator.deallocate(newSlots, newCapacity);
+            throw;
+        }
+        adopt(newSlots, newCapacity, size());
+    }
+
+    // Рост полной очереди. Как у std::vector, новый элемент строится первым, пока старый массив
+    // ещё цел: аргумент может ссылаться на элемент этой же очереди (push(front()))
+    template <typename... Args>
+    T& growAndEmplace(Args&&... args) {
+        size_t count = size();
+        size_t newCapacity = capacity == 0 ? 8 : capacity * 2;
+        T* newSlots = allocator.allocate(newCapacity);
+        T* item = nullptr;
+        try {
+            item = ::new (static_cast<void*>(newSlots + count)) T(std::forward<Args>(args)...);
+            moveTo(newSlots);
+        } catch (...) {
+            if (item) item->~T();
+            allocator.deallocate(newSlots, newCapacity);
+            throw;
+        }
+        adopt(newSlots, newCapacity, count + 1);
+        return *item;
+    }
+
+    void release() {
+        while (head != tail) slot(head++)->~T();
+        if (slots) allocator.deallocate(slots, capacity);
+        slots = nullptr;
+        capacity = 0;
+        head = tail = 0;
+    }
+
+public:
+    // Обход без копирования: от первого элемента к последнему
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const RingQueue* queue, size_t index) : queue(queue), index(index) {}
+        reference operator*() const { return *queue->slot(index); }
+        pointer operator->() const { return queue->slot(index); }
+        const_iterator& operator++() {
+            ++index;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++index;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+    private:
+        const RingQueue* queue;
+        size_t index;
+    };
+
+    RingQueue() = default;
+
+    // Место сразу под count элементов (округляется до степени двойки)
+    explicit RingQueue(size_t count) {
+        reserve(count);
+    }
+
+    // Делегирующий конструктор: после него объект уже построен, поэтому если копирование
+    // элемента бросит исключение, деструктор освободит массив и скопированные элементы
+    RingQueue(const RingQueue& other) : RingQueue(other.size()) {
+        for (const T& item : other) push(item);
+    }
+
+    RingQueue(RingQueue&& other) noexcept
+        : slots(std::exchange(other.slots, nullptr)), capacity(std::exchange(other.capacity, 0)),
+          head(std::exchange(other.head, 0)), tail(std::exchange(other.tail, 0)) {}
+
+    RingQueue& operator=(RingQueue other) noexcept {
+        std::swap(slots, other.slots);
+        std::swap(capacity, other.capacity);
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        return *this;
+    }
+
+    ~RingQueue() {
+        release();
+    }
+
+    void reserve(size_t count) {
+        size_t newCapacity = capacity == 0 ? 8 : capacity;
+        while (newCapacity < count) newCapacity *= 2;
+        if (newCapacity != capacity) reallocate(newCapacity);
+    }
+
+    template <typename... Args>
+    T& emplace(Args&&... args) {
+        if (size() == capacity) return growAndEmplace(std::forward<Args>(args)...);
+        T* item = ::new (static_cast<void*>(slot(tail))) T(std::forward<Args>(args)...);
+        ++tail;
+        return *item;
+    }
+
+    void push(const T& item) {
+        emplace(item);
+    }
+
+    void push(T&& item) {
+        emplace(std::move(item));
+    }
+
+    void pop() {
+        if (empty()) {
+            if (onEmpty == OnEmptyQueue::Throw) {
+                throw std::runtime_error("Cannot pop from empty queue");
+            }
+            return;
+        }
+        slot(head++)->~T();
+    }
+
+    // Первый элемент переносится в item; false — очередь пуста
+    bool try_pop(T& item) {
+        if (empty()) return false;
+        item = std::move(*slot(head));
+        slot(head++)->~T();
+        return true;
+    }
+
+    T& front() {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return *slot(head);
+    }
+
+    const T& front() const {
+        if (empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+        return *slot(head);
+    }
+
+    size_t size() const { return tail - head; }
+    bool empty() const { return head == tail; }
+
+    const_iterator begin() const { return const_iterator(this, head); }
+    const_iterator end() const { return const_iterator(this, tail); }
+
+    void display() const {
+        if (onEmpty == OnEmptyQueue::Throw && empty()) {
+            throw std::runtime_error("Queue is empty");
+        }
+
+        for (const T& item : *this) {
+            std::cout << item << " ";
+        }
+        std::cout << std::endl;
+    }
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+// ===== Реестр типов по текстовому тегу =====
+// Общий для лабораторных 7.1 и 10: подключается через #include "../common/type_registry.h".
+// Каждый тип регистрирует свой тег и запись Info (по умолчанию — загрузчик, читающий поля
+// после тега). Поиск — совершенный хеш: при каждой регистрации подбирается затравка, при
+// которой все теги попадают в разные ячейки, так что поиск — один хеш и одно сравнение строк
+// при любом числе типов. Теги известны только при статической инициализации, поэтому таблица
+// строится тогда же, а не во время компиляции.
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// FNV-1a, 32 бита. basis меняет начальное значение: так реестр перебирает затравки
+inline uint32_t fnv1a(std::string_view data, uint32_t basis = 2166136261u) {
+    uint32_t hash = basis;
+    for (char c : data) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+template <typename Base, typename Info = std::shared_ptr<Base> (*)(std::istream& in)>
+class TypeRegistry {
+public:
+    static TypeRegistry& instance() {
+        static TypeRegistry registry;
+        return registry;
+    }
+
+    // Повторная регистрация тега — std::logic_error
+    bool add(std::string_view tag, const Info& info) {
+        if (find(tag)) {
+            throw std::logic_error("Type is already registered");
+        }
+        types.push_back({tag, info});
+        rebuild();
+        return true;
+    }
+
+    // Указатель действителен, пока не зарегистрирован следующий тип
+    const Info* find(std::string_view tag) const {
+        if (slots.empty()) return nullptr;
+        int index = slots[slotOf(tag, seed)];
+        return index >= 0 && types[index].tag == tag ? &types[index].info : nullptr;
+    }
+
+private:
+    struct Type {
+        std::string_view tag;
+        Info info;
+    };
+
+    size_t slotOf(std::string_view tag, uint32_t salt) const {
+        uint32_t hash = fnv1a(tag, 2166136261u ^ salt);
+        return (hash ^ (hash >> 16)) & (slots.size() - 1);
+    }
+
+    // Таблица вдвое больше числа типов; если ни одна затравка не разводит теги, она удваивается
+    void rebuild() {
+        for (size_t size = 4;; size *= 2) {
+            if (size < types.size() * 2) continue;
+            slots.resize(size);
+            for (uint32_t salt = 0; salt < 256; ++salt) {
+                std::fill(slots.begin(), slots.end(), -1);
+                bool distinct = true;
+                for (size_t i = 0; i < types.size() && distinct; ++i) {
+                    int& slot = slots[slotOf(types[i].tag, salt)];
+                    distinct = slot < 0;
+                    slot = static_cast<int>(i);
+                }
+                if (distinct) {
+                    seed = salt;
+                    return;
+                }
+            }
+        }
+    }
+
+    std::vector<Type> types;
+    std::vector<int> slots;
+    uint32_t seed = 0;
+};
@@ -1,17 +1,29 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include <ostream>
+
+#include "../common/lifetime.h"
+#include "../common/name_table.h"
+#include "../common/combat_events.h"
 
 class Character {
 private:
-    std::string name;  // Приватное поле: имя персонажа
+    NameTable::Id nameId; // Приватное поле: имя персонажа (идентификатор в словаре имён)
     int health;        // Приватное поле: уровень здоровья
     int attack;        // Приватное поле: уровень атаки
     int defense;       // Приватное поле: уровень защиты
+    LIFETIME_TRACKED(Character)
 
 public:
     // Конструктор для инициализации данных
     Character(const std::string& n, int h, int a, int d)
-        : name(n), health(h), attack(a), defense(d) {}
+        : nameId(NameTable::instance().intern(n)), health(h), attack(a), defense(d) {}
 
     // Метод для получения уровня здоровья
     int getHealth() const {
@@ -20,7 +32,7 @@ public:
 
     // Метод для вывода информации о персонаже
     void displayInfo() const {
-        std::cout << "Name: " << name << ", HP: " << health
+        std::cout << "Name: " << NameTable::instance().view(nameId) << ", HP: " << health
                   << ", Attack: " << attack << ", Defense: " << defense << std::endl;
     }
 
@@ -29,9 +41,9 @@ public:
         int damage = attack - enemy.defense;
         if (damage > 0) {
             enemy.health -= damage;
-            std::cout << name << " attacks " << enemy.name << " for " << damage << " damage!" << std::endl;
+            CombatEvents::emit(CombatEventType::Hit, damage, enemy.health, nameId, enemy.nameId);
         } else {
-            std::cout << name << " attacks " << enemy.name << ", but it has no effect!" << std::endl;
+            CombatEvents::emit(CombatEventType::Miss, 0, enemy.health, nameId, enemy.nameId);
         }
     }
 
@@ -39,18 +51,257 @@ public:
     void heal(int amount) {
         health += amount;
         if (health > 100) health = 100;
-        std::cout << name << " healed for " << amount << " HP. Current HP: " << health << std::endl;
+        CombatEvents::emit(CombatEventType::Heal, amount, health, nameId, nameId);
     }
 
     // Метод для получения урона (не менее 0 HP)
     void takeDamage(int amount) {
         health -= amount;
         if (health < 0) health = 0;
-        std::cout << name << " took " << amount << " damage. Current HP: " << health << std::endl;
+        CombatEvents::emit(CombatEventType::Damage, amount, health, nameId, nameId);
     }
 };
 
-int main() {
+// ===== Массовая атака: одна волна над массивами =====
+// Пара i: боец с атакой attack[i] бьёт цель с защитой defense[i] и здоровьем health[i].
+// Урон = attack - defense, применяется только если он положителен; здоровье не опускается ниже 0.
+// Бит i в killMask — цель пала от этого удара, в noEffectMask — удар без эффекта. Вывода нет.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WAVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define WAVE_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WAVE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define WAVE_TARGET(isa)
+#endif
+
+struct WaveResult {
+    size_t kills = 0;
+    size_t noEffect = 0;
+};
+
+// Размер маски в 64-битных словах для n пар
+inline size_t waveMaskWords(size_t n) {
+    return (n + 63) / 64;
+}
+
+// Скалярный вариант для хвоста массива и процессоров без SIMD
+inline void attackWaveScalar(const int* attack, const int* defense, int* health, size_t begin, size_t end,
+                             uint64_t* killMask, uint64_t* noEffectMask) {
+    for (size_t i = begin; i < end; ++i) {
+        int damage = attack[i] - defense[i];
+        uint64_t bit = uint64_t(1) << (i & 63);
+        if (damage > 0) {
+            int before = health[i];
+            int after = before - damage;
+            if (after < 0) after = 0;
+            health[i] = after;
+            if (before > 0 && after == 0) killMask[i >> 6] |= bit;
+        } else {
+            noEffectMask[i >> 6] |= bit;
+        }
+    }
+}
+
+#if WAVE_X86
+WAVE_TARGET("sse4.1")
+inline size_t attackWaveSse41(const int* attack, const int* defense, int* health, size_t n,
+                              uint64_t* killMask, uint64_t* noEffectMask) {
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(attack + i));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(defense + i));
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(health + i));
+        __m128i damage = _mm_sub_epi32(a, d);
+        __m128i effective = _mm_cmpgt_epi32(damage, zero);
+        __m128i hit = _mm_max_epi32(_mm_sub_epi32(h, damage), zero);
+        __m128i after = _mm_blendv_epi8(h, hit, effective);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(health + i), after);
+
+        __m128i kill = _mm_and_si128(_mm_and_si128(effective, _mm_cmpgt_epi32(h, zero)), _mm_cmpeq_epi32(after, zero));
+        uint64_t killBits = static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(kill)));
+        uint64_t noEffectBits = static_cast<uint64_t>(~_mm_movemask_ps(_mm_castsi128_ps(effective)) & 0xF);
+        killMask[i >> 6] |= killBits << (i & 63);
+        noEffectMask[i >> 6] |= noEffectBits << (i & 63);
+    }
+    return i;
+}
+
+WAVE_TARGET("avx2")
+inline size_t attackWaveAvx2(const int* attack, const int* defense, int* health, size_t n,
+                             uint64_t* killMask, uint64_t* noEffectMask) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(attack + i));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(defense + i));
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(health + i));
+        __m256i damage = _mm256_sub_epi32(a, d);
+        __m256i effective = _mm256_cmpgt_epi32(damage, zero);
+        __m256i hit = _mm256_max_epi32(_mm256_sub_epi32(h, damage), zero);
+        __m256i after = _mm256_blendv_epi8(h, hit, effective);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(health + i), after);
+
+        __m256i kill = _mm256_and_si256(_mm256_and_si256(effective, _mm256_cmpgt_epi32(h, zero)),
+                                        _mm256_cmpeq_epi32(after, zero));
+        uint64_t killBits = static_cast<uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(kill)));
+        uint64_t noEffectBits = static_cast<uint64_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(effective)) & 0xFF);
+        killMask[i >> 6] |= killBits << (i & 63);
+        noEffectMask[i >> 6] |= noEffectBits << (i & 63);
+    }
+    return i;
+}
+#endif
+
+enum class WaveIsa { Scalar, Sse41, Avx2 };
+
+// Лучший набор инструкций, доступный на этом процессоре
+inline WaveIsa detectWaveIsa() {
+#if WAVE_X86 && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("avx2")) return WaveIsa::Avx2;
+    if (__builtin_cpu_supports("sse4.1")) return WaveIsa::Sse41;
+#elif WAVE_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    if (osAvx && (info[1] & (1 << 5)) != 0) return WaveIsa::Avx2;
+    if (sse41) return WaveIsa::Sse41;
+#endif
+    return WaveIsa::Scalar;
+}
+
+// Волна атак над n парами; маски должны вмещать waveMaskWords(n) слов и обнуляются здесь
+inline WaveResult applyAttackWave(const int* attack, const int* defense, int* health, size_t n,
+                                  uint64_t* killMask, uint64_t* noEffectMask,
+                                  WaveIsa isa = detectWaveIsa()) {
+    std::fill(killMask, killMask + waveMaskWords(n), 0);
+    std::fill(noEffectMask, noEffectMask + waveMaskWords(n), 0);
+
+    size_t done = 0;
+#if WAVE_X86
+    if (isa == WaveIsa::Avx2) {
+        done = attackWaveAvx2(attack, defense, health, n, killMask, noEffectMask);
+    } else if (isa == WaveIsa::Sse41) {
+        done = attackWaveSse41(attack, defense, health, n, killMask, noEffectMask);
+    }
+#else
+    (void)isa;
+#endif
+    attackWaveScalar(attack, defense, health, done, n, killMask, noEffectMask);
+
+    WaveResult result;
+    for (size_t w = 0; w < waveMaskWords(n); ++w) {
+        result.kills += static_cast<size_t>(std::bitset<64>(killMask[w]).count());
+        result.noEffect += static_cast<size_t>(std::bitset<64>(noEffectMask[w]).count());
+    }
+    return result;
+}
+
+// Замер и сверка вариантов ядра на count парах
+void runWaveBenchmark(size_t count, int waves) {
+    std::cout << "=== Attack wave, " << count << " pairs x " << waves << " waves ===" << std::endl;
+    std::vector<int> attack(count), defense(count), initialHealth(count);
+    uint64_t seed = 12345;
+    auto next = [&seed](int lo, int hi) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return lo + static_cast<int>((seed >> 33) % static_cast<uint64_t>(hi - lo + 1));
+    };
+    for (size_t i = 0; i < count; ++i) {
+        attack[i] = next(5, 30);
+        defense[i] = next(0, 25);
+        initialHealth[i] = next(1, 200);
+    }
+
+    std::vector<int> reference;
+    std::vector<uint64_t> referenceKills;
+    const std::pair<WaveIsa, const char*> variants[] = {
+        {WaveIsa::Scalar, "scalar"}, {WaveIsa::Sse41, "sse4.1"}, {WaveIsa::Avx2, "avx2"}};
+    WaveIsa best = detectWaveIsa();
+
+    for (const auto& variant : variants) {
+        if (static_cast<int>(variant.first) > static_cast<int>(best)) {
+            std::cout << variant.second << ": not supported by this CPU\n";
+            continue;
+        }
+        std::vector<int> health = initialHealth;
+        std::vector<uint64_t> kills(waveMaskWords(count)), noEffect(waveMaskWords(count));
+        WaveResult total;
+        auto start = std::chrono::steady_clock::now();
+        for (int w = 0; w < waves; ++w) {
+            WaveResult r = applyAttackWave(attack.data(), defense.data(), health.data(), count,
+                                           kills.data(), noEffect.data(), variant.first);
+            total.kills += r.kills;
+            total.noEffect += r.noEffect;
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        bool matches = true;
+        if (reference.empty()) {
+            reference = health;
+            referenceKills = kills;
+        } else {
+            matches = health == reference && kills == referenceKills;
+        }
+        std::cout << variant.second << ": " << ns / (double(count) * waves) << " ns/pair, kills "
+                  << total.kills << ", no effect " << total.noEffect
+                  << (matches ? "" : "  MISMATCH with scalar!") << "\n";
+    }
+}
+
+// Замер: count атак без подписчиков, со статистикой и с текстовым выводом в пустой поток
+void runEventsBenchmark(int count) {
+    std::cout << "=== Combat events, " << count << " attacks ===" << std::endl;
+    std::ostream nullOut(nullptr);
+
+    auto run = [count](const char* label) {
+        Character attacker("Attacker", 100, 20, 10);
+        Character target("Target", 100, 15, 12);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) {
+            attacker.attackEnemy(target);
+            if ((i & 1023) == 0) target.heal(50);
+        }
+        CombatEvents::flush();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << ns / count << " ns/attack (target HP " << target.getHealth() << ")\n";
+    };
+
+    run("no subscribers       ");
+    {
+        CombatStats stats;
+        run("stats counters       ");
+        std::cout << "  hits " << stats.count(CombatEventType::Hit) << ", heals " << stats.count(CombatEventType::Heal)
+                  << ", damage dealt " << stats.totalDealt() << "\n";
+    }
+    {
+        CombatRenderer renderer(nullOut);
+        run("text renderer (null) ");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Замеры: --bench [wave|events|all]
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        std::string which = argc > 2 ? argv[2] : "all";
+        if (which == "wave" || which == "all") runWaveBenchmark(1000000, 50);
+        if (which == "events" || which == "all") runEventsBenchmark(1000000);
+        return 0;
+    }
+
+    // События боя выводятся на консоль пачками, после каждого этапа демонстрации
+    CombatRenderer console(std::cout);
+
     // Создаем объекты персонажей
     Character hero("Hero", 100, 20, 10);
     Character monster("Goblin", 50, 15, 5);
@@ -64,6 +315,7 @@ int main() {
     // Демонстрация атаки
     std::cout << "Combat:" << std::endl;
     hero.attackEnemy(monster);
+    CombatEvents::flush();
     monster.displayInfo();
     std::cout << std::endl;
 
@@ -71,12 +323,14 @@ int main() {
     std::cout << "Healing:" << std::endl;
     hero.heal(15);
     monster.heal(10);
+    CombatEvents::flush();
     std::cout << std::endl;
 
     // Демонстрация получения урона
     std::cout << "Taking damage:" << std::endl;
     hero.takeDamage(30);
     monster.takeDamage(20);
+    CombatEvents::flush();
     std::cout << std::endl;
 
     // Финальный статус
@@ -1,10 +1,13 @@
 #include <iostream>
 #include <string>
 
+#include "../common/lifetime.h"
+
 class Entity {
 protected:
     std::string name; // Защищенное поле: имя
     int health;      // Защищенное поле: здоровье
+    LIFETIME_TRACKED(Entity)
 
 public:
     // Конструктор базового класса
@@ -21,6 +24,7 @@ public:
 class Player : public Entity {
 private:
     int experience; // Приватное поле: опыт
+    LIFETIME_TRACKED(Player)
 
 public:
     // Конструктор производного класса
@@ -37,6 +41,7 @@ public:
 class Enemy : public Entity {
 private:
     std::string type; // Приватное поле: тип врага
+    LIFETIME_TRACKED(Enemy)
 
 public:
     // Конструктор производного класса
@@ -54,6 +59,7 @@ public:
 class Boss : public Enemy {
 private:
     std::string specialAbility; // Уникальная способность босса
+    LIFETIME_TRACKED(Boss)
 
 public:
     // Конструктор
@@ -2,48 +2,191 @@
 #include <string>
 #include <ctime>
 #include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <memory>
+#include <variant>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <ostream>
+#include <charconv>
+
+#include "../common/lifetime.h"
+#include "../common/game_rng.h"
+#include "../common/name_table.h"
+#include "../common/combat_events.h"
+
+// ===== Эффекты во времени (яд, горение, регенерация, усиления) =====
+// Иерархическое колесо таймеров: 4 уровня по 64 ячейки на такт игры, дальше — список переполнения.
+// Вставка и отмена — O(1) через двусвязные списки индексов; за такт обрабатывается только
+// текущая ячейка нижнего уровня и изредка перекладывается одна ячейка верхнего, поэтому
+// стоимость такта не зависит от числа ждущих эффектов.
+
+enum class EffectKind : uint8_t { None, Poison, Burn, Regen, AttackBuff };
+
+class Entity;
+
+class EffectWheel {
+public:
+    struct Handle {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+
+    // Урон/лечение amount каждые period тактов, всего ticks раз; когда цель погибает
+    // (здоровье <= 0), её урон и лечение снимаются, не дожидаясь последнего такта.
+    // Усиление атаки действует сразу и снимается через period * ticks тактов (считается в 64 битах).
+    // Колесо не владеет целями: перед удалением сущности её эффекты нужно отменить или вызвать clear().
+    Handle add(Entity& target, EffectKind kind, int amount, uint32_t period, uint32_t ticks);
+    bool cancel(Handle handle);
+    void advance(uint64_t ticks = 1);
+    void clear();
+
+    uint64_t now() const { return current; }
+    size_t active() const { return live; }
+
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kBits = 6;
+    static constexpr uint32_t kSlots = 1u << kBits;
+    static constexpr uint32_t kOverflow = kLevels * kSlots;
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    struct Node {
+        Entity* target;
+        uint64_t due;
+        uint64_t period;
+        int amount;
+        uint32_t remaining;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t generation;
+        uint32_t list; // номер ячейки, npos — узел свободен
+        EffectKind kind;
+    };
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(uint32_t list);
+    void fire(uint32_t index);
+
+    std::vector<Node> nodes;
+    uint32_t heads[kOverflow + 1];
+    uint32_t freeHead = npos;
+    uint64_t current = 0;
+    size_t live = 0;
+
+public:
+    EffectWheel() { std::fill(std::begin(heads), std::end(heads), npos); }
+};
+
+// Параметры особой атаки, известные на этапе компиляции: шанс в процентах, множитель и бонус урона,
+// а также эффект во времени, который особая атака накладывает на цель (урон за такт и число тактов)
+template <uint32_t Chance, int Multiplier, int Bonus,
+          EffectKind Effect = EffectKind::None, int EffectAmount = 0, uint32_t EffectTicks = 0>
+struct ProcPolicy {
+    static constexpr uint32_t chance = Chance;
+    static constexpr EffectKind effect = Effect;
+    static constexpr int effectAmount = EffectAmount;
+    static constexpr uint32_t effectTicks = EffectTicks;
+    static int apply(int damage) { return damage * Multiplier + Bonus; }
+};
+
+using NoProc = ProcPolicy<0, 1, 0>;
+using CriticalProc = ProcPolicy<20, 2, 0>;                            // 20% шанс, урон x2
+using PoisonProc = ProcPolicy<30, 1, 5, EffectKind::Poison, 2, 5>;    // 30% шанс, +5 урона, яд 2 x 5 тактов
+using FireProc = ProcPolicy<50, 1, 10, EffectKind::Burn, 4, 3>;       // 50% шанс, +10 урона, горение 4 x 3 такта
 
 // Базовый класс Entity
 class Entity {
 protected:
-    std::string name;
+    NameTable::Id nameId; // имя хранится в словаре имён
     int health;
     int attack;
     int defense;
+    GameRng rng; // Собственный поток случайных чисел сущности
+    LIFETIME_TRACKED(Entity)
 
 public:
+    // Колесо, в которое особые атаки ставят эффекты; без него остаётся только мгновенный бонус урона
+    static inline EffectWheel* effectWheel = nullptr;
+
     Entity(const std::string& n, int h, int a, int d)
-        : name(n), health(h), attack(a), defense(d) {}
+        : nameId(NameTable::instance().intern(n)), health(h), attack(a), defense(d), rng(makeRngStream()) {}
 
     // Виртуальный метод для атаки
     virtual void performAttack(Entity& target) {
+        bool proc = false;
+        int damage = strike(target, proc);
+        if (damage > 0) {
+            if (proc) CombatEvents::emit(CombatEventType::Crit, 0, target.health, nameId, target.nameId, procMessage());
+            CombatEvents::emit(CombatEventType::Hit, damage, target.health, nameId, target.nameId);
+        } else {
+            CombatEvents::emit(CombatEventType::Miss, 0, target.health, nameId, target.nameId);
+        }
+    }
+
+    using Proc = NoProc;
+
+    // Расчёт и нанесение урона без вывода; proc — сработала ли особая атака
+    virtual int strike(Entity& target, bool& proc) {
+        return strikeWith<Proc>(target, proc);
+    }
+
+    // Та же атака без виртуального вызова: параметры особой атаки подставляются при компиляции
+    template <typename P>
+    int strikeWith(Entity& target, bool& proc) {
+        proc = false;
         int damage = attack - target.getDefense();
         if (damage > 0) {
+            if (P::chance > 0 && rng.chance(P::chance)) {
+                damage = P::apply(damage);
+                proc = true;
+                if (P::effect != EffectKind::None && effectWheel) {
+                    effectWheel->add(target, P::effect, P::effectAmount, 1, P::effectTicks);
+                }
+            }
             target.takeDamage(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
-        } else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
         }
+        return damage;
     }
 
+    // Сообщение об особой атаке
+    virtual const char* procMessage() const { return ""; }
+
     // Методы доступа к защищенным полям
-    std::string getName() const { return name; }
+    std::string_view getName() const { return NameTable::instance().view(nameId); }
+    NameTable::Id getNameId() const { return nameId; }
     int getHealth() const { return health; }
     int getAttack() const { return attack; }
     int getDefense() const { return defense; }
     void takeDamage(int amount) { health -= amount; }
+    void adjustAttack(int delta) { attack += delta; }
+
+    // Лечение без вывода (регенерация, эффекты); предел здоровья — 100
+    void restoreHealth(int amount) {
+        health += amount;
+        if (health > 100) health = 100;
+    }
 
     // Виртуальный метод для вывода информации
     virtual void displayInfo() const {
-        std::cout << "Name: " << name << ", HP: " << health
+        std::cout << "Name: " << getName() << ", HP: " << health
                   << ", Attack: " << attack << ", Defense: " << defense << std::endl;
     }
 
     // Виртуальный метод для лечения
     virtual void heal(int amount) {
-        health += amount;
-        if (health > 100) health = 100;
-        std::cout << name << " healed for " << amount << " HP. Current HP: " << health << std::endl;
+        restoreHealth(amount);
+        CombatEvents::emit(CombatEventType::Heal, amount, health, nameId, nameId);
     }
 
     virtual ~Entity() {}
@@ -51,54 +194,42 @@ public:
 
 // Класс Character с критическим ударом
 class Character : public Entity {
+    LIFETIME_TRACKED(Character)
 public:
     Character(const std::string& n, int h, int a, int d)
         : Entity(n, h, a, d) {}
 
-    void performAttack(Entity& target) override {
-        int damage = attack - target.getDefense();
-        if (damage > 0) {
-            // 20% шанс критического удара
-            if (rand() % 100 < 20) {
-                damage *= 2;
-                std::cout << "Critical hit! ";
-            }
-            target.takeDamage(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
-        } else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
-        }
+    using Proc = CriticalProc; // 20% шанс критического удара
+
+    int strike(Entity& target, bool& proc) override {
+        return strikeWith<Proc>(target, proc);
     }
 
+    const char* procMessage() const override { return "Critical hit! "; }
+
     void displayInfo() const override {
-        std::cout << "Character: " << name << ", HP: " << health
+        std::cout << "Character: " << getName() << ", HP: " << health
                   << ", Attack: " << attack << ", Defense: " << defense << std::endl;
     }
 };
 
 // Класс Monster с ядовитой атакой
 class Monster : public Entity {
+    LIFETIME_TRACKED(Monster)
 public:
     Monster(const std::string& n, int h, int a, int d)
         : Entity(n, h, a, d) {}
 
-    void performAttack(Entity& target) override {
-        int damage = attack - target.getDefense();
-        if (damage > 0) {
-            // 30% шанс ядовитой атаки
-            if (rand() % 100 < 30) {
-                damage += 5;
-                std::cout << "Poisonous attack! ";
-            }
-            target.takeDamage(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
-        } else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
-        }
+    using Proc = PoisonProc; // 30% шанс ядовитой атаки
+
+    int strike(Entity& target, bool& proc) override {
+        return strikeWith<Proc>(target, proc);
     }
 
+    const char* procMessage() const override { return "Poisonous attack! "; }
+
     void displayInfo() const override {
-        std::cout << "Monster: " << name << ", HP: " << health
+        std::cout << "Monster: " << getName() << ", HP: " << health
                   << ", Attack: " << attack << ", Defense: " << defense << std::endl;
     }
 };
@@ -107,34 +238,587 @@ public:
 class Boss : public Monster {
 private:
     std::string specialAbility;
+    LIFETIME_TRACKED(Boss)
 
 public:
     Boss(const std::string& n, int h, int a, int d, const std::string& ability)
         : Monster(n, h, a, d), specialAbility(ability) {}
 
-    void performAttack(Entity& target) override {
-        int damage = attack - target.getDefense();
-        if (damage > 0) {
-            // 50% шанс огненной атаки
-            if (rand() % 100 < 50) {
-                damage += 10;
-                std::cout << "Fire attack! ";
-            }
-            target.takeDamage(damage);
-            std::cout << name << " attacks " << target.getName() << " for " << damage << " damage!\n";
-        } else {
-            std::cout << name << " attacks " << target.getName() << ", but it has no effect!\n";
-        }
+    using Proc = FireProc; // 50% шанс огненной атаки
+
+    int strike(Entity& target, bool& proc) override {
+        return strikeWith<Proc>(target, proc);
     }
 
+    const char* procMessage() const override { return "Fire attack! "; }
+
     void displayInfo() const override {
         Monster::displayInfo();
         std::cout << "Special Ability: " << specialAbility << std::endl;
     }
 };
 
-int main() {
-    srand(static_cast<unsigned>(time(0))); // Инициализация генератора случайных чисел
+// ===== Колесо эффектов: реализация =====
+
+EffectWheel::Handle EffectWheel::add(Entity& target, EffectKind kind, int amount, uint32_t period, uint32_t ticks) {
+    if (period == 0 || ticks == 0) throw std::invalid_argument("effect period and ticks must be positive");
+    uint32_t index = freeHead;
+    if (index != npos) {
+        freeHead = nodes[index].next;
+    } else {
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(Node{});
+    }
+    Node& node = nodes[index];
+    node.target = &target;
+    node.kind = kind;
+    node.amount = amount;
+    if (kind == EffectKind::AttackBuff) {
+        target.adjustAttack(amount);
+        node.period = uint64_t(period) * ticks;
+        node.remaining = 1;
+    } else {
+        node.period = period;
+        node.remaining = ticks;
+    }
+    node.due = current + node.period;
+    link(index);
+    ++live;
+    return Handle{index, node.generation};
+}
+
+bool EffectWheel::cancel(Handle handle) {
+    if (handle.index >= nodes.size()) return false;
+    Node& node = nodes[handle.index];
+    if (node.generation != handle.generation || node.list == npos) return false;
+    unlink(handle.index);
+    if (node.kind == EffectKind::AttackBuff) node.target->adjustAttack(-node.amount);
+    release(handle.index);
+    return true;
+}
+
+void EffectWheel::advance(uint64_t ticks) {
+    for (uint64_t t = 0; t < ticks; ++t) {
+        ++current;
+        // Переложить ячейки верхних уровней, чей интервал начинается с этого такта
+        for (int level = 1; level < kLevels; ++level) {
+            uint64_t span = uint64_t(1) << (kBits * level);
+            if (current & (span - 1)) break;
+            cascade(level * kSlots + static_cast<uint32_t>((current >> (kBits * level)) & (kSlots - 1)));
+        }
+        if ((current & ((uint64_t(1) << (kBits * (kLevels - 1))) - 1)) == 0) cascade(kOverflow);
+
+        // Пачка эффектов, срабатывающих в этом такте: список снимается целиком до обработки
+        uint32_t index = heads[current & (kSlots - 1)];
+        heads[current & (kSlots - 1)] = npos;
+        while (index != npos) {
+            uint32_t next = nodes[index].next;
+            fire(index);
+            index = next;
+        }
+    }
+}
+
+void EffectWheel::clear() {
+    for (uint32_t index = 0; index < nodes.size(); ++index) {
+        if (nodes[index].list == npos) continue;
+        unlink(index);
+        if (nodes[index].kind == EffectKind::AttackBuff) nodes[index].target->adjustAttack(-nodes[index].amount);
+        release(index);
+    }
+}
+
+void EffectWheel::link(uint32_t index) {
+    Node& node = nodes[index];
+    uint64_t delta = node.due - current;
+    uint32_t list = kOverflow;
+    for (int level = 0; level < kLevels; ++level) {
+        if (delta < (uint64_t(1) << (kBits * (level + 1)))) {
+            list = level * kSlots + static_cast<uint32_t>((node.due >> (kBits * level)) & (kSlots - 1));
+            break;
+        }
+    }
+    node.list = list;
+    node.prev = npos;
+    node.next = heads[list];
+    if (node.next != npos) nodes[node.next].prev = index;
+    heads[list] = index;
+}
+
+void EffectWheel::unlink(uint32_t index) {
+    Node& node = nodes[index];
+    if (node.prev != npos) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[node.list] = node.next;
+    }
+    if (node.next != npos) nodes[node.next].prev = node.prev;
+}
+
+void EffectWheel::release(uint32_t index) {
+    Node& node = nodes[index];
+    node.list = npos;
+    ++node.generation;
+    node.next = freeHead;
+    freeHead = index;
+    --live;
+}
+
+void EffectWheel::cascade(uint32_t list) {
+    uint32_t index = heads[list];
+    heads[list] = npos;
+    while (index != npos) {
+        uint32_t next = nodes[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void EffectWheel::fire(uint32_t index) {
+    Node& node = nodes[index];
+    // Погибшую цель не лечат и не добивают; снятие усиления выполняется всегда
+    if (node.kind != EffectKind::AttackBuff && node.target->getHealth() <= 0) {
+        release(index);
+        return;
+    }
+    switch (node.kind) {
+    case EffectKind::Poison:
+    case EffectKind::Burn:
+        node.target->takeDamage(node.amount);
+        CombatEvents::emit(CombatEventType::Damage, node.amount, node.target->getHealth(), node.target->getNameId(),
+                           node.target->getNameId());
+        break;
+    case EffectKind::Regen:
+        node.target->restoreHealth(node.amount);
+        break;
+    case EffectKind::AttackBuff:
+        node.target->adjustAttack(-node.amount);
+        break;
+    case EffectKind::None:
+        break;
+    }
+    if (--node.remaining > 0 && (node.kind == EffectKind::AttackBuff || node.target->getHealth() > 0)) {
+        node.due += node.period;
+        link(index);
+    } else {
+        release(index);
+    }
+}
+
+// ===== Статическая диспетчеризация атаки =====
+// Виртуальный strike() остаётся для расширения иерархии, а для известного набора типов
+// есть два пути без косвенного вызова: закрытый std::variant и пачки однотипных бойцов.
+
+using AnyCombatant = std::variant<Character, Monster, Boss>;
+
+// Атака бойца известного типа: T::Proc выбирается при компиляции, вызов встраивается
+template <typename T>
+int strikeStatic(T& attacker, Entity& target, bool& proc) {
+    return attacker.template strikeWith<typename T::Proc>(target, proc);
+}
+
+int strikeVariant(AnyCombatant& attacker, Entity& target, bool& proc) {
+    return std::visit([&](auto& a) { return strikeStatic(a, target, proc); }, attacker);
+}
+
+Entity& asEntity(AnyCombatant& combatant) {
+    return std::visit([](auto& c) -> Entity& { return c; }, combatant);
+}
+
+// Пачка атак однотипных бойцов: targets[i] — цель бойца attackers[i]; возвращает суммарный урон
+template <typename T>
+long long strikeBatch(std::vector<T>& attackers, const std::vector<Entity*>& targets) {
+    long long dealt = 0;
+    for (size_t i = 0; i < attackers.size(); ++i) {
+        bool proc = false;
+        int damage = strikeStatic(attackers[i], *targets[i], proc);
+        if (damage > 0) dealt += damage;
+    }
+    return dealt;
+}
+
+// ===== ECS: бойцы как столбцы данных (struct-of-arrays) =====
+// Здоровье, атака и защита лежат в отдельных непрерывных массивах, имя — побочный компонент,
+// нужный только при выводе. Особая атака — метка, по которой система обрабатывает бойцов пачкой.
+
+enum class ProcKind : uint8_t { None, Critical, Poison, Fire };
+
+class CombatWorld {
+public:
+    using EntityId = uint32_t;
+
+    // Компоненты
+    std::vector<int> health;
+    std::vector<int> attack;
+    std::vector<int> defense;
+    std::vector<EntityId> target;     // кого атакует боец
+    std::vector<NameTable::Id> names; // побочный компонент: идентификаторы из словаря имён
+
+    explicit CombatWorld(GameRng rng) : rng(rng) {}
+
+    void reserve(size_t n) {
+        health.reserve(n);
+        attack.reserve(n);
+        defense.reserve(n);
+        target.reserve(n);
+        names.reserve(n);
+    }
+
+    EntityId spawn(const std::string& name, int h, int a, int d, ProcKind proc) {
+        EntityId id = static_cast<EntityId>(health.size());
+        health.push_back(h);
+        attack.push_back(a);
+        defense.push_back(d);
+        target.push_back(id);
+        names.push_back(NameTable::instance().intern(name));
+        groupOf(proc).push_back(id);
+        return id;
+    }
+
+    size_t size() const { return health.size(); }
+
+    // Один такт: каждая система обрабатывает свою группу бойцов; возвращает суммарный урон
+    long long tick() {
+        long long dealt = 0;
+        dealt += attackSystem(plain, 0, [](int damage) { return damage; });
+        dealt += attackSystem(critical, 20, [](int damage) { return damage * 2; });
+        dealt += attackSystem(poison, 30, [](int damage) { return damage + 5; });
+        dealt += attackSystem(fire, 50, [](int damage) { return damage + 10; });
+        return dealt;
+    }
+
+    void displayInfo(EntityId id) const {
+        std::cout << "Name: " << NameTable::instance().view(names[id]) << ", HP: " << health[id]
+                  << ", Attack: " << attack[id] << ", Defense: " << defense[id] << std::endl;
+    }
+
+private:
+    // Система атаки для бойцов с одинаковой меткой особой атаки
+    template <typename Proc>
+    long long attackSystem(const std::vector<EntityId>& group, uint32_t chance, Proc proc) {
+        long long dealt = 0;
+        for (EntityId id : group) {
+            EntityId t = target[id];
+            int damage = attack[id] - defense[t];
+            if (damage > 0) {
+                if (chance > 0 && rng.chance(chance)) damage = proc(damage);
+                health[t] -= damage;
+                dealt += damage;
+            }
+        }
+        return dealt;
+    }
+
+    std::vector<EntityId>& groupOf(ProcKind proc) {
+        switch (proc) {
+            case ProcKind::Critical: return critical;
+            case ProcKind::Poison: return poison;
+            case ProcKind::Fire: return fire;
+            default: return plain;
+        }
+    }
+
+    // Метки особой атаки: списки бойцов по группам
+    std::vector<EntityId> plain;
+    std::vector<EntityId> critical;
+    std::vector<EntityId> poison;
+    std::vector<EntityId> fire;
+    GameRng rng;
+};
+
+// Замер стоимости одного броска процента разными способами
+template <typename Roll>
+void benchmarkRolls(const char* label, long long rolls, Roll roll) {
+    auto start = std::chrono::steady_clock::now();
+    long long hits = 0;
+    for (long long i = 0; i < rolls; ++i) {
+        hits += roll();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << label << ": " << ns / rolls << " ns/roll (hits: " << hits << ")\n";
+}
+
+void runRngBenchmark(long long rolls) {
+    std::cout << "=== RNG benchmark, " << rolls << " rolls ===" << std::endl;
+    benchmarkRolls("rand() % 100", rolls, [] { return rand() % 100 < 20; });
+
+    std::mt19937 mt(static_cast<unsigned>(rngMasterSeed));
+    benchmarkRolls("mt19937 + distribution", rolls, [&mt] {
+        std::uniform_int_distribution<> dist(0, 99);
+        return dist(mt) < 20;
+    });
+
+    GameRng rng = makeRngStream();
+    benchmarkRolls("GameRng::chance", rolls, [&rng] { return rng.chance(20); });
+}
+
+// Сравнение: иерархия с указателем на каждую сущность против ECS, count бойцов, ticks тактов.
+// Промахи кэша удобно смотреть снаружи: perf stat -e cache-misses ./laba13 --bench ecs
+void runEcsBenchmark(size_t count, int ticks) {
+    std::cout << "=== ECS vs Entity hierarchy, " << count << " entities, " << ticks << " ticks ===" << std::endl;
+    GameRng setup = makeRngStream();
+    const char* names[] = {"Hero", "Goblin", "Dragon"};
+
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.reserve(count);
+    CombatWorld world(makeRngStream());
+    world.reserve(count);
+    std::vector<size_t> targets(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        int kind = static_cast<int>(setup.bounded(3));
+        int h = setup.range(50, 200);
+        int a = setup.range(10, 30);
+        int d = setup.range(0, 20);
+        if (kind == 0) {
+            entities.push_back(std::make_unique<Character>(names[kind], h, a, d));
+        } else if (kind == 1) {
+            entities.push_back(std::make_unique<Monster>(names[kind], h, a, d));
+        } else {
+            entities.push_back(std::make_unique<Boss>(names[kind], h, a, d, "Fire Breath"));
+        }
+        ProcKind proc = kind == 0 ? ProcKind::Critical : kind == 1 ? ProcKind::Poison : ProcKind::Fire;
+        world.spawn(names[kind], h, a, d, proc);
+        targets[i] = setup.bounded(static_cast<uint32_t>(count));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        world.target[i] = static_cast<CombatWorld::EntityId>(targets[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long long dealt = 0;
+    for (int t = 0; t < ticks; ++t) {
+        for (size_t i = 0; i < count; ++i) {
+            bool proc = false;
+            int damage = entities[i]->strike(*entities[targets[i]], proc);
+            if (damage > 0) dealt += damage;
+        }
+    }
+    double hierarchyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Hierarchy (virtual strike via Entity*): " << hierarchyNs / (double(count) * ticks)
+              << " ns/entity, " << double(count) * ticks / hierarchyNs * 1e3 << " M entity-attacks/s"
+              << " (damage " << dealt << ")\n";
+
+    start = std::chrono::steady_clock::now();
+    dealt = 0;
+    for (int t = 0; t < ticks; ++t) {
+        dealt += world.tick();
+    }
+    double ecsNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "ECS (SoA columns, batched systems):     " << ecsNs / (double(count) * ticks)
+              << " ns/entity, " << double(count) * ticks / ecsNs * 1e3 << " M entity-attacks/s"
+              << " (damage " << dealt << ")\n";
+}
+
+// Сравнение диспетчеризации атаки на большом смешанном массиве: virtual, std::variant и пачки по типам
+void runDispatchBenchmark(size_t count, int rounds) {
+    std::cout << "=== Attack dispatch, " << count << " mixed attackers, " << rounds << " rounds ===" << std::endl;
+    GameRng setup = makeRngStream();
+    std::vector<int> kinds(count);
+    for (auto& kind : kinds) kind = static_cast<int>(setup.bounded(3));
+
+    // Одинаковые наборы бойцов для трёх способов хранения
+    std::vector<std::unique_ptr<Entity>> pointers;
+    std::vector<AnyCombatant> variants;
+    std::vector<Character> characters;
+    std::vector<Monster> monsters;
+    std::vector<Boss> bosses;
+    pointers.reserve(count);
+    variants.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        int a = 10 + static_cast<int>(i % 20);
+        int d = static_cast<int>(i % 15);
+        if (kinds[i] == 0) {
+            pointers.push_back(std::make_unique<Character>("Hero", 1000000, a, d));
+            variants.emplace_back(std::in_place_type<Character>, "Hero", 1000000, a, d);
+            characters.emplace_back("Hero", 1000000, a, d);
+        } else if (kinds[i] == 1) {
+            pointers.push_back(std::make_unique<Monster>("Goblin", 1000000, a, d));
+            variants.emplace_back(std::in_place_type<Monster>, "Goblin", 1000000, a, d);
+            monsters.emplace_back("Goblin", 1000000, a, d);
+        } else {
+            pointers.push_back(std::make_unique<Boss>("Dragon", 1000000, a, d, "Fire Breath"));
+            variants.emplace_back(std::in_place_type<Boss>, "Dragon", 1000000, a, d, "Fire Breath");
+            bosses.emplace_back("Dragon", 1000000, a, d, "Fire Breath");
+        }
+    }
+
+    std::vector<uint32_t> targetIndex(count);
+    for (auto& t : targetIndex) t = setup.bounded(static_cast<uint32_t>(count));
+
+    std::vector<Entity*> pointerTargets(count);
+    std::vector<Entity*> variantTargets(count);
+    for (size_t i = 0; i < count; ++i) {
+        pointerTargets[i] = pointers[targetIndex[i]].get();
+        variantTargets[i] = &asEntity(variants[targetIndex[i]]);
+    }
+    // Для пачек цели берутся из тех же однотипных массивов по порядку
+    std::vector<Entity*> all;
+    for (auto& c : characters) all.push_back(&c);
+    for (auto& m : monsters) all.push_back(&m);
+    for (auto& b : bosses) all.push_back(&b);
+    std::vector<Entity*> characterTargets, monsterTargets, bossTargets;
+    for (size_t i = 0, k = 0; k < 3; ++k) {
+        std::vector<Entity*>& out = k == 0 ? characterTargets : k == 1 ? monsterTargets : bossTargets;
+        size_t n = k == 0 ? characters.size() : k == 1 ? monsters.size() : bosses.size();
+        for (size_t j = 0; j < n; ++j, ++i) out.push_back(all[targetIndex[i]]);
+    }
+
+    auto report = [count, rounds](const char* label, double ns, long long dealt) {
+        std::cout << label << ": " << ns / (double(count) * rounds) << " ns/attack (damage " << dealt << ")\n";
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    long long dealt = 0;
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < count; ++i) {
+            bool proc = false;
+            int damage = pointers[i]->strike(*pointerTargets[i], proc);
+            if (damage > 0) dealt += damage;
+        }
+    }
+    report("virtual (Entity*)        ", std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count(), dealt);
+
+    start = std::chrono::steady_clock::now();
+    dealt = 0;
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < count; ++i) {
+            bool proc = false;
+            int damage = strikeVariant(variants[i], *variantTargets[i], proc);
+            if (damage > 0) dealt += damage;
+        }
+    }
+    report("std::variant + visit     ", std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count(), dealt);
+
+    start = std::chrono::steady_clock::now();
+    dealt = 0;
+    for (int r = 0; r < rounds; ++r) {
+        dealt += strikeBatch(characters, characterTargets);
+        dealt += strikeBatch(monsters, monsterTargets);
+        dealt += strikeBatch(bosses, bossTargets);
+    }
+    report("static batches per type  ", std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count(), dealt);
+}
+
+// Колесо эффектов: count целей с активными ядом и регенерацией плюс idle долгих усилений на каждую.
+// Средняя стоимость такта не должна расти с числом ждущих эффектов.
+void runEffectsBenchmark(size_t count, int ticks) {
+    std::cout << "=== Effect wheel, " << count << " entities, " << ticks << " ticks ===" << std::endl;
+    std::vector<Monster> mobs;
+    mobs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        mobs.emplace_back("Mob" + std::to_string(i), 100, 10, 5);
+    }
+
+    for (int idle : {0, 8}) {
+        EffectWheel wheel;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<EffectWheel::Handle> buffs;
+        for (size_t i = 0; i < count; ++i) {
+            wheel.add(mobs[i], EffectKind::Poison, 1, 1 + i % 4, 1000000);
+            wheel.add(mobs[i], EffectKind::Regen, 1, 5, 1000000);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            for (int k = 0; k < idle; ++k) {
+                buffs.push_back(wheel.add(mobs[i], EffectKind::AttackBuff, 1, 100000 + 1000 * k, 1));
+            }
+        }
+        double setupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        wheel.advance(ticks);
+        double tickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (auto handle : buffs) wheel.cancel(handle);
+        double cancelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "idle buffs per entity " << idle << ": " << wheel.active() + buffs.size() << " effects, insert "
+                  << setupMs << " ms, " << tickMs / ticks << " ms/tick, cancel " << buffs.size() << " in "
+                  << cancelMs << " ms" << std::endl;
+        wheel.clear();
+    }
+}
+
+// Замер: count атак через performAttack без подписчиков, со статистикой и с текстовым выводом в пустой поток
+void runEventsBenchmark(int count) {
+    std::cout << "=== Combat events, " << count << " attacks ===" << std::endl;
+    std::ostream nullOut(nullptr);
+
+    auto run = [count](const char* label) {
+        Character attacker("Attacker", 100, 20, 10);
+        Monster target("Target", 100, 15, 12);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) {
+            attacker.performAttack(target);
+        }
+        CombatEvents::flush();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << ns / count << " ns/attack (target HP " << target.getHealth() << ")\n";
+    };
+
+    run("no subscribers       ");
+    {
+        CombatStats stats;
+        run("stats counters       ");
+        std::cout << "  hits " << stats.count(CombatEventType::Hit) << ", crits " << stats.count(CombatEventType::Crit)
+                  << ", damage dealt " << stats.totalDealt() << "\n";
+    }
+    {
+        CombatRenderer renderer(nullOut);
+        run("text renderer (null) ");
+    }
+}
+
+// Число целиком, без знака и хвоста; false — строка не число или не помещается в 64 бита
+bool parseNumber(const char* text, uint64_t& value) {
+    const char* end = text + std::char_traits<char>::length(text);
+    uint64_t parsed = 0;
+    auto res = std::from_chars(text, end, parsed);
+    if (res.ec != std::errc() || res.ptr != end || res.ptr == text) return false;
+    value = parsed;
+    return true;
+}
+
+int printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--seed N] [--bench [rng|ecs|dispatch|effects|events|all]]\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    // Зерно можно задать явно (--seed N), тогда бой повторяется один в один
+    uint64_t seed = static_cast<uint64_t>(time(0));
+    // Замеры: --bench [rng|ecs|dispatch|effects|events|all]
+    std::string bench;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seed") {
+            if (i + 1 >= argc || !parseNumber(argv[++i], seed)) return printUsage(argv[0]);
+        } else if (arg == "--bench") {
+            bench = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "all";
+            if (bench != "rng" && bench != "ecs" && bench != "dispatch" && bench != "effects" &&
+                bench != "events" && bench != "all") {
+                return printUsage(argv[0]);
+            }
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return printUsage(argv[0]);
+        }
+    }
+    setMasterSeed(seed);
+    srand(static_cast<unsigned>(seed));
+
+    if (!bench.empty()) {
+        if (bench == "rng" || bench == "all") runRngBenchmark(100000000);
+        if (bench == "ecs" || bench == "all") runEcsBenchmark(1000000, 20);
+        if (bench == "dispatch" || bench == "all") runDispatchBenchmark(1000000, 20);
+        if (bench == "effects" || bench == "all") runEffectsBenchmark(200000, 200);
+        if (bench == "events" || bench == "all") runEventsBenchmark(1000000);
+        return 0;
+    }
+
+    // События боя выводятся на консоль пачками, после каждого этапа демонстрации
+    CombatRenderer console(std::cout);
 
     // Создание объектов
     Character hero("Hero", 100, 20, 10);
@@ -156,11 +840,13 @@ int main() {
     hero.performAttack(goblin);
     goblin.performAttack(hero);
     dragon.performAttack(hero);
+    CombatEvents::flush();
     std::cout << std::endl;
 
     // Демонстрация лечения
     std::cout << "=== Healing ===" << std::endl;
     hero.heal(20);
+    CombatEvents::flush();
     std::cout << std::endl;
 
     // Финальный статус
@@ -6,6 +6,16 @@
 #include <algorithm>
 #include <exception>
 
+#include "../common/type_registry.h"
+
+
+class User;
+
+// Loadable user types are registered by tag in TypeRegistry<User> (common/type_registry.h):
+// each type provides a static load(std::istream&) that reads the fields following the tag,
+// so the loader handles a new type without being touched.
+#define REGISTER_USER_TYPE(Type, tag) \
+    static const bool Type##Registered = TypeRegistry<User>::instance().add(tag, &Type::load)
 
 class User {
 private:
@@ -52,8 +62,29 @@ public:
     virtual void displayInfo() const {
             std::cout << "Пользователь: " << name << ", ID: " << id << ", Уровень доступа: " << accessLevel << std::endl;
     }
+
+    // One line of the users file: type tag, common fields, then the type's own fields
+    virtual void save(std::ostream& out) const {
+        out << "User ";
+        saveCommon(out);
+        out << std::endl;
+    }
+
+    static std::shared_ptr<User> load(std::istream& in) {
+        std::string name;
+        int id, accessLevel;
+        in >> name >> id >> accessLevel;
+        return std::make_shared<User>(name, id, accessLevel);
+    }
+
+protected:
+    void saveCommon(std::ostream& out) const {
+        out << name << " " << id << " " << accessLevel;
+    }
 };
 
+REGISTER_USER_TYPE(User, "User");
+
 // Derived Student class
 class Student : public User {
 private:
@@ -76,8 +107,23 @@ public:
         std::cout << "Студент: " << getName() << ", ID: " << getId()
                   << ", Уровень доступа: " << getAccessLevel() << ", Группа: " << group << std::endl;
     }
+
+    void save(std::ostream& out) const override {
+        out << "Student ";
+        saveCommon(out);
+        out << " " << group << std::endl;
+    }
+
+    static std::shared_ptr<User> load(std::istream& in) {
+        std::string name, group;
+        int id, accessLevel;
+        in >> name >> id >> accessLevel >> group;
+        return std::make_shared<Student>(name, id, accessLevel, group);
+    }
 };
 
+REGISTER_USER_TYPE(Student, "Student");
+
 // Derived Teacher class
 class Teacher : public User {
 private:
@@ -100,8 +146,23 @@ public:
         std::cout << "Преподаватель: " << getName() << ", ID: " << getId()
                   << ", Уровень доступа: " << getAccessLevel() << ", Кафедра: " << department << std::endl;
     }
+
+    void save(std::ostream& out) const override {
+        out << "Teacher ";
+        saveCommon(out);
+        out << " " << department << std::endl;
+    }
+
+    static std::shared_ptr<User> load(std::istream& in) {
+        std::string name, department;
+        int id, accessLevel;
+        in >> name >> id >> accessLevel >> department;
+        return std::make_shared<Teacher>(name, id, accessLevel, department);
+    }
 };
 
+REGISTER_USER_TYPE(Teacher, "Teacher");
+
 // Derived Administrator class
 class Administrator : public User {
 private:
@@ -128,8 +189,23 @@ public:
         std::cout << "Администратор: " << getName() << ", ID: " << getId()
                   << ", Уровень доступа: " << getAccessLevel() << ", Уровень администратора: " << adminLevel << std::endl;
     }
+
+    void save(std::ostream& out) const override {
+        out << "Administrator ";
+        saveCommon(out);
+        out << " " << adminLevel << std::endl;
+    }
+
+    static std::shared_ptr<User> load(std::istream& in) {
+        std::string name;
+        int id, accessLevel, adminLevel;
+        in >> name >> id >> accessLevel >> adminLevel;
+        return std::make_shared<Administrator>(name, id, accessLevel, adminLevel);
+    }
 };
 
+REGISTER_USER_TYPE(Administrator, "Administrator");
+
 // Resource class representing university resources
 class Resource {
 private:
@@ -239,23 +315,8 @@ public:
             throw std::runtime_error("Failed to open users file for writing");
         }
         for (const auto& user : users) {
-            // Save user type info for loading
-            if (dynamic_cast<Student*>(user.get())) {
-                uFile << "Student ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
-                uFile << static_cast<Student*>(user.get())->getGroup() << std::endl;
-            } else if (dynamic_cast<Teacher*>(user.get())) {
-                uFile << "Teacher ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
-                uFile << static_cast<Teacher*>(user.get())->getDepartment() << std::endl;
-            } else if (dynamic_cast<Administrator*>(user.get())) {
-                uFile << "Administrator ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << " ";
-                uFile << static_cast<Administrator*>(user.get())->getAdminLevel() << std::endl;
-            } else {
-                uFile << "User ";
-                uFile << user->getName() << " " << user->getId() << " " << user->getAccessLevel() << std::endl;
-            }
+            // Each type writes its own tag for loading
+            user->save(uFile);
         }
         uFile.close();
 
@@ -280,26 +341,12 @@ public:
         }
         std::string userType;
         while (uFile >> userType) {
-            if (userType == "Student") {
-                std::string name, group;
-                int id, accessLevel;
-                uFile >> name >> id >> accessLevel >> group;
-                addUser(std::make_shared<Student>(name, id, accessLevel, group));
-            } else if (userType == "Teacher") {
-                std::string name, department;
-                int id, accessLevel;
-                uFile >> name >> id >> accessLevel >> department;
-                addUser(std::make_shared<Teacher>(name, id, accessLevel, department));
-            } else if (userType == "Administrator") {
-                std::string name;
-                int id, accessLevel, adminLevel;
-                uFile >> name >> id >> accessLevel >> adminLevel;
-                addUser(std::make_shared<Administrator>(name, id, accessLevel, adminLevel));
-            } else if (userType == "User") {
-                std::string name;
-                int id, accessLevel;
-                uFile >> name >> id >> accessLevel;
-                addUser(std::make_shared<User>(name, id, accessLevel));
+            // The concrete type is found by its tag in the registry; users of a type this
+            // system does not hold are read and dropped, so the stream stays in step
+            if (auto load = TypeRegistry<User>::instance().find(userType)) {
+                if (auto user = std::dynamic_pointer_cast<UserType>((*load)(uFile))) {
+                    addUser(user);
+                }
             } else {
                 // Unknown user type, skip line
                 std::string skipLine;
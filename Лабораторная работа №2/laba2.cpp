@@ -1,23 +1,37 @@
 #include <iostream>
 #include <string>
 
+#include "../common/lifetime.h"
+
+// LIFETIME_TRACE=0 отключает печать "created!/destroyed!" из конструкторов
+#ifndef LIFETIME_TRACE
+#define LIFETIME_TRACE 1
+#endif
+
+#if LIFETIME_TRACE
+#define LIFETIME_LOG(expr) (std::cout << expr)
+#else
+#define LIFETIME_LOG(expr) ((void)0)
+#endif
+
 class Character {
 private:
     std::string name;
     int health;
     int attack;
     int defense;
+    LIFETIME_TRACKED(Character)
 
 public:
     // Конструктор
     Character(const std::string& n, int h, int a, int d)
         : name(n), health(h), attack(a), defense(d) {
-        std::cout << "Character " << name << " created!\n";
+        LIFETIME_LOG("Character " << name << " created!\n");
     }
 
     // Деструктор
     ~Character() {
-        std::cout << "Character " << name << " destroyed!\n";
+        LIFETIME_LOG("Character " << name << " destroyed!\n");
     }
 
     void displayInfo() const {
@@ -32,17 +46,18 @@ private:
     int health;
     int attack;
     int defense;
+    LIFETIME_TRACKED(Monster)
 
 public:
     // Конструктор
     Monster(const std::string& n, int h, int a, int d)
         : name(n), health(h), attack(a), defense(d) {
-        std::cout << "Monster " << name << " created!\n";
+        LIFETIME_LOG("Monster " << name << " created!\n");
     }
 
     // Деструктор
     ~Monster() {
-        std::cout << "Monster " << name << " destroyed!\n";
+        LIFETIME_LOG("Monster " << name << " destroyed!\n");
     }
 
     void displayInfo() const {
@@ -56,17 +71,18 @@ private:
     std::string name;
     int damage;
     float weight;
+    LIFETIME_TRACKED(Weapon)
 
 public:
     // Конструктор
     Weapon(const std::string& n, int d, float w)
         : name(n), damage(d), weight(w) {
-        std::cout << "Weapon " << name << " created!\n";
+        LIFETIME_LOG("Weapon " << name << " created!\n");
     }
 
     // Деструктор
     ~Weapon() {
-        std::cout << "Weapon " << name << " destroyed!\n";
+        LIFETIME_LOG("Weapon " << name << " destroyed!\n");
     }
 
     void displayInfo() const {
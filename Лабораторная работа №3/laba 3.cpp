@@ -1,21 +1,58 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "../common/lifetime.h"
+
+// Персонаж из примера к лабораторной: сравнение по имени и здоровью и вывод в поток
+class Character {
+private:
+    std::string name;
+    int health;
+    int attack;
+    int defense;
+
+public:
+    Character(const std::string& n, int h, int a, int d) : name(n), health(h), attack(a), defense(d) {}
+
+    bool operator==(const Character& other) const {
+        return name == other.name && health == other.health;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Character& character) {
+        os << "Character: " << character.name << ", HP: " << character.health
+           << ", Attack: " << character.attack << ", Defense: " << character.defense;
+        return os;
+    }
+};
 
 class Weapon {
 private:
     std::string name;
     int damage;
+    float weight; // вес в кг, как у Weapon из лабораторной №2
+    LIFETIME_TRACKED(Weapon)
 
 public:
-    Weapon(const std::string& n, int d) : name(n), damage(d) {}
+    Weapon(const std::string& n, int d, float w = 0.0f) : name(n), damage(d), weight(w) {}
 
     // Перегрузка оператора + для сложения урона
+    // (каждый вызов склеивает имена; для длинных цепочек — CombinedWeapon)
     Weapon operator+(const Weapon& other) const {
         std::string newName = name + " + " + other.name;
         int newDamage = damage + other.damage;
-        return Weapon(newName, newDamage);
+        return Weapon(newName, newDamage, weight + other.weight);
     }
 
+    const std::string& getName() const { return name; }
+    int getDamage() const { return damage; }
+    float getWeight() const { return weight; }
+
     // Перегрузка оператора > для сравнения урона
     bool operator>(const Weapon& other) const {
         return damage > other.damage;
@@ -28,7 +65,523 @@ public:
     }
 };
 
-int main() {
+// ===== Комбинации оружия без склейки строк =====
+// Оружие хранится в арсенале один раз; комбинация — это список номеров оружия
+// с уже посчитанными суммарным уроном и весом. Имя собирается только при выводе.
+
+class Armory;
+
+class CombinedWeapon {
+private:
+    const Armory* armory;
+    std::vector<uint32_t> parts; // номера оружия в арсенале
+    int damage = 0;
+    float weight = 0.0f;
+    LIFETIME_TRACKED(CombinedWeapon)
+
+public:
+    explicit CombinedWeapon(const Armory& armory) : armory(&armory) {}
+    CombinedWeapon(const Armory& armory, uint32_t first) : armory(&armory) { *this += first; }
+
+    // Добавление оружия в комбинацию: амортизированно O(1), без новых строк
+    CombinedWeapon& operator+=(uint32_t weaponId);
+
+    friend CombinedWeapon operator+(CombinedWeapon combo, uint32_t weaponId) {
+        combo += weaponId;
+        return combo;
+    }
+
+    bool operator>(const CombinedWeapon& other) const {
+        return damage > other.damage;
+    }
+
+    int getDamage() const { return damage; }
+    float getWeight() const { return weight; }
+    const std::vector<uint32_t>& components() const { return parts; }
+
+    // Имя вида "Sword + Bow", собирается по требованию
+    std::string renderName() const;
+
+    friend std::ostream& operator<<(std::ostream& os, const CombinedWeapon& combo) {
+        os << "Weapon: " << combo.renderName() << ", Damage: " << combo.damage;
+        return os;
+    }
+};
+
+// Арсенал: хранилище оружия и подбор лучшего снаряжения
+class Armory {
+private:
+    std::vector<Weapon> weapons;
+
+public:
+    // Шаг дискретизации веса при подборе снаряжения, кг
+    static constexpr float kWeightStep = 0.1f;
+    // Предел памяти для каждой из таблиц подбора (лучший урон и биты выбора)
+    static constexpr size_t kMaxTableBytes = size_t(512) << 20;
+
+    uint32_t add(const std::string& name, int damage, float weight) {
+        weapons.emplace_back(name, damage, weight);
+        return static_cast<uint32_t>(weapons.size() - 1);
+    }
+
+    const Weapon& get(uint32_t id) const { return weapons[id]; }
+    size_t size() const { return weapons.size(); }
+    void reserve(size_t n) { weapons.reserve(n); }
+
+    // Комбинация с максимальным уроном при суммарном весе не больше maxWeight (рюкзак 0/1).
+    // Вес округляется вверх до kWeightStep, поэтому лимит никогда не превышается.
+    // Время O(n * W), память O(n * W) бит, где W = maxWeight / kWeightStep.
+    // Если таблицы не укладываются в kMaxTableBytes — std::length_error, а не попытка выделить память.
+    CombinedWeapon bestLoadout(float maxWeight) const {
+        float steps = maxWeight > 0 ? std::floor(maxWeight / kWeightStep + 1e-4f) : 0.0f;
+        if (!(steps < static_cast<float>(kMaxTableBytes / sizeof(long long)))) {
+            throw std::length_error("Loadout weight limit is too large");
+        }
+        size_t capacity = static_cast<size_t>(steps);
+        size_t rowWords = capacity / 64 + 1;
+        if (!weapons.empty() && rowWords > kMaxTableBytes / sizeof(uint64_t) / weapons.size()) {
+            throw std::length_error("Loadout weight limit is too large for this many weapons");
+        }
+        std::vector<long long> best(capacity + 1, 0);
+        std::vector<uint64_t> taken(weapons.size() * rowWords, 0);
+        std::vector<size_t> units(weapons.size());
+
+        for (size_t i = 0; i < weapons.size(); ++i) {
+            const Weapon& w = weapons[i];
+            // Сравнение до перевода в size_t: вес может быть сколь угодно большим
+            float need = std::ceil(std::max(0.0f, w.getWeight()) / kWeightStep - 1e-4f);
+            if (w.getDamage() <= 0 || !(need <= static_cast<float>(capacity))) continue;
+            units[i] = static_cast<size_t>(need);
+
+            uint64_t* row = &taken[i * rowWords];
+            for (size_t c = capacity + 1; c-- > units[i];) {
+                long long withIt = best[c - units[i]] + w.getDamage();
+                if (withIt > best[c]) {
+                    best[c] = withIt;
+                    row[c / 64] |= uint64_t(1) << (c % 64);
+                }
+            }
+        }
+
+        // Восстановление выбора с последнего оружия к первому
+        CombinedWeapon loadout(*this);
+        std::vector<uint32_t> chosen;
+        size_t c = capacity;
+        for (size_t i = weapons.size(); i-- > 0;) {
+            if (taken[i * rowWords + c / 64] & (uint64_t(1) << (c % 64))) {
+                chosen.push_back(static_cast<uint32_t>(i));
+                c -= units[i];
+            }
+        }
+        for (size_t k = chosen.size(); k-- > 0;) loadout += chosen[k];
+        return loadout;
+    }
+};
+
+CombinedWeapon& CombinedWeapon::operator+=(uint32_t weaponId) {
+    const Weapon& w = armory->get(weaponId);
+    parts.push_back(weaponId);
+    damage += w.getDamage();
+    weight += w.getWeight();
+    return *this;
+}
+
+std::string CombinedWeapon::renderName() const {
+    std::string result;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i > 0) result += " + ";
+        result += armory->get(parts[i]).getName();
+    }
+    return result;
+}
+
+// ===== Каталог оружия с индексами =====
+// Столбцы (имя, урон, вес) хранятся раздельно. Индексы перестраиваются пачкой:
+// список по убыванию урона (поразрядная сортировка) и k-d дерево по (урон, вес)
+// для запросов "урон >= X и вес <= Y". Новые записи сначала попадают в буфер,
+// который просматривается линейно, пока не станет достаточно большим для перестройки.
+class WeaponCatalog {
+public:
+    static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+
+    uint32_t insert(const std::string& name, int damage, float weight) {
+        uint32_t id = append(name, damage, weight);
+        if (size() - indexed > std::max<size_t>(4096, indexed / 8)) {
+            rebuildIndexes();
+        }
+        return id;
+    }
+
+    void bulkLoad(const std::vector<Weapon>& weapons) {
+        names.reserve(names.size() + weapons.size());
+        damages.reserve(damages.size() + weapons.size());
+        weights.reserve(weights.size() + weapons.size());
+        for (const auto& w : weapons) append(w.getName(), w.getDamage(), w.getWeight());
+        rebuildIndexes();
+    }
+
+    size_t size() const { return damages.size(); }
+
+    Weapon get(uint32_t id) const { return Weapon(names[id], damages[id], weights[id]); }
+
+    // k записей с наибольшим уроном, по убыванию
+    std::vector<uint32_t> topByDamage(size_t k) const {
+        std::vector<uint32_t> candidates(byDamage.begin(), byDamage.begin() + std::min(k, byDamage.size()));
+        for (size_t id = indexed; id < size(); ++id) candidates.push_back(static_cast<uint32_t>(id));
+        size_t n = std::min(k, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(),
+                          [this](uint32_t a, uint32_t b) { return damages[a] > damages[b]; });
+        candidates.resize(n);
+        return candidates;
+    }
+
+    // Все записи с уроном >= minDamage и весом <= maxWeight
+    std::vector<uint32_t> query(int minDamage, float maxWeight) const {
+        std::vector<uint32_t> out;
+        queryKd(0, kd.size(), 0, minDamage, maxWeight, out);
+        for (size_t id = indexed; id < size(); ++id) {
+            if (damages[id] >= minDamage && weights[id] <= maxWeight) out.push_back(static_cast<uint32_t>(id));
+        }
+        return out;
+    }
+
+    // Лучший урон на килограмм; поддерживается при каждой вставке
+    uint32_t bestDamagePerKg() const { return bestRatio; }
+
+private:
+    struct KdPoint {
+        int damage;
+        float weight;
+        uint32_t id;
+    };
+
+    static double ratioOf(int damage, float weight) {
+        return damage / std::max(static_cast<double>(weight), 1e-6);
+    }
+
+    uint32_t append(const std::string& name, int damage, float weight) {
+        uint32_t id = static_cast<uint32_t>(damages.size());
+        names.push_back(name);
+        damages.push_back(damage);
+        weights.push_back(weight);
+        if (bestRatio == npos || ratioOf(damage, weight) > ratioOf(damages[bestRatio], weights[bestRatio])) {
+            bestRatio = id;
+        }
+        return id;
+    }
+
+    void rebuildIndexes() {
+        sortByDamageDesc();
+        kd.resize(size());
+        for (size_t id = 0; id < size(); ++id) {
+            kd[id] = {damages[id], weights[id], static_cast<uint32_t>(id)};
+        }
+        buildKd(0, kd.size(), 0);
+        indexed = size();
+    }
+
+    // Поразрядная сортировка (LSD, два прохода по 16 бит) по убыванию урона
+    void sortByDamageDesc() {
+        size_t n = size();
+        std::vector<uint32_t> keys(n);
+        for (size_t id = 0; id < n; ++id) {
+            keys[id] = ~(static_cast<uint32_t>(damages[id]) ^ 0x80000000u);
+        }
+        std::vector<uint32_t> order(n), next(n);
+        for (size_t id = 0; id < n; ++id) order[id] = static_cast<uint32_t>(id);
+
+        std::vector<size_t> counts(65537);
+        for (int shift = 0; shift < 32; shift += 16) {
+            std::fill(counts.begin(), counts.end(), 0);
+            for (uint32_t id : order) ++counts[((keys[id] >> shift) & 0xFFFF) + 1];
+            for (size_t b = 1; b < counts.size(); ++b) counts[b] += counts[b - 1];
+            for (uint32_t id : order) next[counts[(keys[id] >> shift) & 0xFFFF]++] = id;
+            order.swap(next);
+        }
+        byDamage.swap(order);
+    }
+
+    // Неявное k-d дерево: медиана диапазона — узел, чётная глубина делит по урону, нечётная — по весу
+    void buildKd(size_t lo, size_t hi, int depth) {
+        if (hi - lo <= 1) return;
+        size_t mid = lo + (hi - lo) / 2;
+        if (depth % 2 == 0) {
+            std::nth_element(kd.begin() + lo, kd.begin() + mid, kd.begin() + hi,
+                             [](const KdPoint& a, const KdPoint& b) { return a.damage < b.damage; });
+        } else {
+            std::nth_element(kd.begin() + lo, kd.begin() + mid, kd.begin() + hi,
+                             [](const KdPoint& a, const KdPoint& b) { return a.weight < b.weight; });
+        }
+        buildKd(lo, mid, depth + 1);
+        buildKd(mid + 1, hi, depth + 1);
+    }
+
+    void queryKd(size_t lo, size_t hi, int depth, int minDamage, float maxWeight, std::vector<uint32_t>& out) const {
+        if (lo >= hi) return;
+        size_t mid = lo + (hi - lo) / 2;
+        const KdPoint& p = kd[mid];
+        if (p.damage >= minDamage && p.weight <= maxWeight) out.push_back(p.id);
+
+        // Слева значения не больше узла, справа — не меньше
+        bool visitLeft = depth % 2 == 0 ? p.damage >= minDamage : true;
+        bool visitRight = depth % 2 == 0 ? true : p.weight <= maxWeight;
+        if (visitLeft) queryKd(lo, mid, depth + 1, minDamage, maxWeight, out);
+        if (visitRight) queryKd(mid + 1, hi, depth + 1, minDamage, maxWeight, out);
+    }
+
+    // Столбцы
+    std::vector<std::string> names;
+    std::vector<int> damages;
+    std::vector<float> weights;
+
+    // Индексы (покрывают записи с номерами меньше indexed)
+    std::vector<uint32_t> byDamage;
+    std::vector<KdPoint> kd;
+    size_t indexed = 0;
+    uint32_t bestRatio = npos;
+};
+
+// Замер: цепочка operator+ со склейкой имён против CombinedWeapon и подбор снаряжения
+void runArmoryBenchmark(size_t weaponCount, float maxWeight) {
+    std::cout << "=== Armory benchmark, " << weaponCount << " weapons ===" << std::endl;
+    Armory armory;
+    armory.reserve(weaponCount);
+    uint64_t seed = 42;
+    auto next = [&seed](uint32_t bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>((seed >> 33) % bound);
+    };
+    for (size_t i = 0; i < weaponCount; ++i) {
+        armory.add("Weapon" + std::to_string(i), 1 + static_cast<int>(next(100)), 0.5f + next(100) / 10.0f);
+    }
+
+    const size_t chain = 5000;
+    auto start = std::chrono::steady_clock::now();
+    Weapon concatenated = armory.get(0);
+    for (size_t i = 1; i < chain; ++i) {
+        concatenated = concatenated + armory.get(static_cast<uint32_t>(i));
+    }
+    double concatMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    CombinedWeapon combo(armory, 0);
+    for (size_t i = 1; i < chain; ++i) {
+        combo += static_cast<uint32_t>(i);
+    }
+    double comboMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Chain of " << chain << " weapons: Weapon::operator+ " << concatMs << " ms, CombinedWeapon "
+              << comboMs << " ms (damage " << concatenated.getDamage() << " / " << combo.getDamage() << ")\n";
+
+    start = std::chrono::steady_clock::now();
+    CombinedWeapon loadout = armory.bestLoadout(maxWeight);
+    double solveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Best loadout under " << maxWeight << " kg: " << loadout.components().size() << " weapons, damage "
+              << loadout.getDamage() << ", weight " << loadout.getWeight() << " kg, solved in " << solveMs << " ms\n";
+}
+
+// Замер каталога против линейного прохода с operator> по вектору Weapon
+void runCatalogBenchmark(size_t count, int repeats) {
+    std::cout << "=== Weapon catalog, " << count << " weapons, " << repeats << " queries each ===" << std::endl;
+    std::vector<Weapon> weapons;
+    weapons.reserve(count);
+    uint64_t seed = 7;
+    auto next = [&seed](uint32_t bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>((seed >> 33) % bound);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        weapons.emplace_back("Weapon" + std::to_string(i), static_cast<int>(next(1000)), 0.1f + next(500) / 10.0f);
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    WeaponCatalog catalog;
+    catalog.bulkLoad(weapons);
+    std::cout << "Bulk load + index build: " << ms(start) << " ms\n";
+
+    const size_t k = 10;
+    const int minDamage = 990;
+    const float maxWeight = 2.0f;
+    size_t found = 0;
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) found += catalog.topByDamage(k).size();
+    double catalogTop = ms(start);
+    start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> order(count);
+    for (int r = 0; r < repeats; ++r) {
+        for (size_t i = 0; i < count; ++i) order[i] = static_cast<uint32_t>(i);
+        std::partial_sort(order.begin(), order.begin() + k, order.end(),
+                          [&weapons](uint32_t a, uint32_t b) { return weapons[a] > weapons[b]; });
+        found += order[0];
+    }
+    std::cout << "Top-" << k << " by damage: catalog " << catalogTop / repeats << " ms, linear operator> "
+              << ms(start) / repeats << " ms\n";
+
+    start = std::chrono::steady_clock::now();
+    size_t hits = 0;
+    for (int r = 0; r < repeats; ++r) hits = catalog.query(minDamage, maxWeight).size();
+    double catalogRange = ms(start);
+    start = std::chrono::steady_clock::now();
+    Weapon threshold("threshold", minDamage - 1);
+    size_t linearHits = 0;
+    for (int r = 0; r < repeats; ++r) {
+        linearHits = 0;
+        for (const auto& w : weapons) {
+            if (w > threshold && w.getWeight() <= maxWeight) ++linearHits;
+        }
+    }
+    std::cout << "Damage >= " << minDamage << " and weight <= " << maxWeight << " kg (" << hits << "/" << linearHits
+              << " hits): catalog " << catalogRange / repeats << " ms, linear " << ms(start) / repeats << " ms\n";
+
+    start = std::chrono::steady_clock::now();
+    uint32_t best = WeaponCatalog::npos;
+    for (int r = 0; r < repeats; ++r) best = catalog.bestDamagePerKg();
+    double catalogRatio = ms(start);
+    start = std::chrono::steady_clock::now();
+    size_t bestLinear = 0;
+    for (int r = 0; r < repeats; ++r) {
+        bestLinear = 0;
+        for (size_t i = 1; i < count; ++i) {
+            if (weapons[i].getDamage() / weapons[i].getWeight() >
+                weapons[bestLinear].getDamage() / weapons[bestLinear].getWeight()) {
+                bestLinear = i;
+            }
+        }
+    }
+    std::cout << "Best damage per kg: catalog " << catalogRatio / repeats << " ms, linear " << ms(start) / repeats
+              << " ms (" << catalog.get(best).getName() << " / " << weapons[bestLinear].getName() << ")\n";
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < 100000; ++i) {
+        catalog.insert("New" + std::to_string(i), static_cast<int>(next(1000)), 0.1f + next(500) / 10.0f);
+    }
+    std::cout << "100000 incremental inserts: " << ms(start) << " ms (checksum " << found << ")\n";
+}
+
+// Самопроверка: ответы каталога и подбор снаряжения против полного перебора.
+// false — хотя бы одна проверка не прошла
+bool runSelfTest() {
+    bool passed = true;
+    auto check = [&passed](bool condition, const std::string& what) {
+        std::cout << (condition ? "  ok      " : "  FAILED  ") << what << std::endl;
+        passed = passed && condition;
+    };
+    uint64_t seed = 11;
+    auto next = [&seed](uint32_t bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<uint32_t>((seed >> 33) % bound);
+    };
+    auto ratio = [](int damage, float weight) { return damage / std::max(static_cast<double>(weight), 1e-6); };
+
+    std::cout << "=== Weapon catalog ===" << std::endl;
+    // Вставки по одной идут в буфер и время от времени перестраивают индексы, поэтому
+    // запросы проверяются и на буфере, и на индексах, и на их смеси
+    std::vector<Weapon> initial;
+    for (int i = 0; i < 3000; ++i) {
+        initial.emplace_back("Weapon" + std::to_string(i), static_cast<int>(next(2000)) - 1000, next(500) / 10.0f);
+    }
+    WeaponCatalog catalog;
+    catalog.bulkLoad(initial);
+    std::vector<Weapon> all = initial;
+    bool rangeOk = true;
+    bool topOk = true;
+    bool ratioOk = true;
+    for (int step = 0; step < 30000; ++step) {
+        int damage = static_cast<int>(next(2000)) - 1000;
+        float weight = next(500) / 10.0f;
+        catalog.insert("New" + std::to_string(step), damage, weight);
+        all.emplace_back("New" + std::to_string(step), damage, weight);
+        if (step % 733 != 0) continue;
+
+        int minDamage = static_cast<int>(next(2000)) - 1000;
+        float maxWeight = next(500) / 10.0f;
+        std::vector<uint32_t> hits = catalog.query(minDamage, maxWeight);
+        std::sort(hits.begin(), hits.end());
+        std::vector<uint32_t> expected;
+        for (uint32_t id = 0; id < all.size(); ++id) {
+            if (all[id].getDamage() >= minDamage && all[id].getWeight() <= maxWeight) expected.push_back(id);
+        }
+        rangeOk = rangeOk && hits == expected;
+
+        size_t k = 1 + next(50);
+        std::vector<uint32_t> top = catalog.topByDamage(k);
+        std::vector<int> damages;
+        for (const auto& w : all) damages.push_back(w.getDamage());
+        std::sort(damages.rbegin(), damages.rend());
+        topOk = topOk && top.size() == std::min(k, all.size());
+        for (size_t i = 0; i < top.size() && topOk; ++i) topOk = all[top[i]].getDamage() == damages[i];
+
+        const Weapon& best = all[catalog.bestDamagePerKg()];
+        for (const auto& w : all) {
+            ratioOk = ratioOk && ratio(w.getDamage(), w.getWeight()) <= ratio(best.getDamage(), best.getWeight());
+        }
+    }
+    check(rangeOk, "query(minDamage, maxWeight) matches a linear scan");
+    check(topOk, "topByDamage(k) matches a full sort");
+    check(ratioOk, "bestDamagePerKg() matches a linear scan");
+    WeaponCatalog empty;
+    check(empty.topByDamage(5).empty() && empty.query(0, 10.0f).empty() && empty.bestDamagePerKg() == WeaponCatalog::npos,
+          "empty catalog answers nothing");
+
+    std::cout << "=== Best loadout ===" << std::endl;
+    bool loadoutOk = true;
+    for (int round = 0; round < 300; ++round) {
+        Armory armory;
+        size_t n = 1 + next(12);
+        for (size_t i = 0; i < n; ++i) armory.add("Weapon", static_cast<int>(next(60)) - 5, next(60) / 10.0f);
+        float limit = next(80) / 10.0f;
+        size_t capacity = static_cast<size_t>(std::floor(limit / Armory::kWeightStep + 1e-4f));
+        long long best = 0;
+        for (uint32_t mask = 0; mask < (1u << n); ++mask) {
+            long long damage = 0;
+            size_t units = 0;
+            for (uint32_t i = 0; i < n; ++i) {
+                if (!(mask >> i & 1)) continue;
+                damage += armory.get(i).getDamage();
+                units += static_cast<size_t>(std::ceil(armory.get(i).getWeight() / Armory::kWeightStep - 1e-4f));
+            }
+            if (units <= capacity) best = std::max(best, damage);
+        }
+        CombinedWeapon loadout = armory.bestLoadout(limit);
+        loadoutOk = loadoutOk && loadout.getDamage() == best && loadout.getWeight() <= limit + 1e-3f;
+    }
+    check(loadoutOk, "bestLoadout matches brute force on 300 small armories");
+    Armory large;
+    for (int i = 0; i < 1000; ++i) large.add("Weapon", 5, 1.0f);
+    bool threw = false;
+    try {
+        large.bestLoadout(1e12f);
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    check(threw, "a limit whose tables do not fit is rejected with std::length_error");
+
+    std::cout << (passed ? "All checks passed" : "SOME CHECKS FAILED") << std::endl;
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    // Самопроверка каталога и подбора снаряжения; код возврата 1 — есть ошибки
+    if (argc > 1 && std::string(argv[1]) == "--selftest") {
+        return runSelfTest() ? 0 : 1;
+    }
+
+    // Замеры: --bench [armory|catalog|all]
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        std::string which = argc > 2 ? argv[2] : "all";
+        if (which != "armory" && which != "catalog" && which != "all") {
+            std::cerr << "Usage: " << argv[0] << " --bench [armory|catalog|all]" << std::endl;
+            return 1;
+        }
+        if (which == "armory" || which == "all") runArmoryBenchmark(10000, 50.0f);
+        if (which == "catalog" || which == "all") runCatalogBenchmark(1000000, 20);
+        return 0;
+    }
+
     // Демонстрация работы операторов для класса Character (из примера)
     Character hero1("Hero", 100, 20, 10);
     Character hero2("Hero", 100, 20, 10);
@@ -54,16 +607,30 @@ int main() {
 
     // Использование оператора >
     if (axe > sword) {
-        std::cout << axe.name << " is stronger than " << sword.name << std::endl;
+        std::cout << axe.getName() << " is stronger than " << sword.getName() << std::endl;
     } else {
-        std::cout << axe.name << " is not stronger than " << sword.name << std::endl;
+        std::cout << axe.getName() << " is not stronger than " << sword.getName() << std::endl;
     }
 
     if (bow > combined) {
-        std::cout << bow.name << " is stronger than combined weapon" << std::endl;
+        std::cout << bow.getName() << " is stronger than combined weapon" << std::endl;
     } else {
-        std::cout << "Combined weapon is stronger than " << bow.name << std::endl;
+        std::cout << "Combined weapon is stronger than " << bow.getName() << std::endl;
     }
 
+    // Комбинации через арсенал: имя собирается только при выводе
+    Armory armory;
+    uint32_t swordId = armory.add("Sword", 50, 3.0f);
+    uint32_t bowId = armory.add("Bow", 30, 1.5f);
+    armory.add("Axe", 60, 5.5f);
+    uint32_t daggerId = armory.add("Dagger", 15, 0.5f);
+
+    CombinedWeapon set = CombinedWeapon(armory, swordId) + bowId + daggerId;
+    std::cout << set << ", Weight: " << set.getWeight() << " kg" << std::endl;
+
+    // Лучшее снаряжение, которое можно унести (не более 6 кг)
+    CombinedWeapon loadout = armory.bestLoadout(6.0f);
+    std::cout << "Best loadout (<= 6 kg): " << loadout << ", Weight: " << loadout.getWeight() << " kg" << std::endl;
+
     return 0;
 }
\ No newline at end of file
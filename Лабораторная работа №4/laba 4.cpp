@@ -3,9 +3,12 @@
 #include <string>
 #include <vector>
 
+#include "../common/lifetime.h"
+
 class Inventory {
 private:
     std::vector<std::unique_ptr<std::string>> items; // Динамический массив строк
+    LIFETIME_TRACKED(Inventory)
 
 public:
     // Добавление предмета в инвентарь
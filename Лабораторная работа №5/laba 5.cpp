@@ -2,9 +2,23 @@
 #include <vector>
 #include <queue>
 #include <memory>
+#include <string>
+#include <stdexcept>
+#include <iterator>
+#include <utility>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <charconv>
+
+#include "../common/lifetime.h"
+#include "../common/ring_queue.h"
 
 // Базовый класс Entity (для примера GameManager)
 class Entity {
+    LIFETIME_TRACKED(Entity)
 public:
     virtual ~Entity() = default;
     virtual void displayInfo() const = 0;
@@ -14,6 +28,7 @@ class Player : public Entity {
     std::string name;
     int health;
     int level;
+    LIFETIME_TRACKED(Player)
 
 public:
     Player(const std::string& n, int h, int l) : name(n), health(h), level(l) {}
@@ -26,6 +41,7 @@ class Enemy : public Entity {
     std::string name;
     int health;
     std::string type;
+    LIFETIME_TRACKED(Enemy)
 
 public:
     Enemy(const std::string& n, int h, const std::string& t) : name(n), health(h), type(t) {}
@@ -41,8 +57,9 @@ private:
     std::vector<T> entities;
 
 public:
-    void addEntity(const T& entity) {
-        entities.push_back(entity);
+    // По значению: копируемые указатели копируются, unique_ptr передаётся перемещением
+    void addEntity(T entity) {
+        entities.push_back(std::move(entity));
     }
 
     void displayAll() const {
@@ -52,34 +69,290 @@ public:
     }
 };
 
-// Шаблонный класс Queue
+// Шаблонный класс Queue: кольцевой буфер из common/ring_queue.h; pop() пустой очереди ничего не делает
+template <typename T>
+using Queue = RingQueue<T, OnEmptyQueue::Ignore>;
+
+// Очередь для передачи элементов между двумя потоками: один поток только кладёт, другой только
+// забирает. Ёмкость фиксирована (степень двойки), замков нет, каждая операция завершается
+// за конечное число шагов (wait-free): при полной или пустой очереди она возвращает false.
+// Каждый поток пишет только свой индекс, а чужой читает с acquire и запоминает, чтобы реже
+// обращаться к строке кэша другого потока.
+template <typename T>
+class SpscQueue {
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::allocator<T> allocator;
+    size_t capacity;
+    T* slots;
+    alignas(kCacheLine) std::atomic<size_t> head{0}; // пишет только потребитель
+    size_t knownTail = 0;                             // последний увиденный потребителем tail
+    alignas(kCacheLine) std::atomic<size_t> tail{0}; // пишет только производитель
+    size_t knownHead = 0;                             // последний увиденный производителем head
+
+    static size_t roundUp(size_t count) {
+        size_t result = 2;
+        while (result < count) result *= 2;
+        return result;
+    }
+
+    T* slot(size_t index) const { return slots + (index & (capacity - 1)); }
+
+public:
+    explicit SpscQueue(size_t count) : capacity(roundUp(count)), slots(allocator.allocate(capacity)) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue() {
+        for (size_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); ++i) {
+            slot(i)->~T();
+        }
+        allocator.deallocate(slots, capacity);
+    }
+
+    // Только из потока-производителя
+    template <typename... Args>
+    bool try_emplace(Args&&... args) {
+        size_t index = tail.load(std::memory_order_relaxed);
+        if (index - knownHead == capacity) {
+            knownHead = head.load(std::memory_order_acquire);
+            if (index - knownHead == capacity) return false;
+        }
+        ::new (static_cast<void*>(slot(index))) T(std::forward<Args>(args)...);
+        tail.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& item) { return try_emplace(item); }
+    bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+    // Только из потока-потребителя
+    bool try_pop(T& item) {
+        size_t index = head.load(std::memory_order_relaxed);
+        if (index == knownTail) {
+            knownTail = tail.load(std::memory_order_acquire);
+            if (index == knownTail) return false;
+        }
+        T* current = slot(index);
+        item = std::move(*current);
+        current->~T();
+        head.store(index + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// std::queue под замком — обычный способ передать элементы между потоками, для сравнения
 template <typename T>
-class Queue {
+class LockedQueue {
 private:
+    std::mutex lock;
     std::queue<T> items;
 
 public:
-    void push(const T& item) {
-        items.push(item);
+    bool try_push(T item) {
+        std::lock_guard<std::mutex> guard(lock);
+        items.push(std::move(item));
+        return true;
+    }
+
+    bool try_pop(T& item) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (items.empty()) return false;
+        item = std::move(items.front());
+        items.pop();
+        return true;
     }
+};
+
+// Queue против std::queue в одном потоке и SpscQueue против очереди под замком между двумя
+void runQueueBenchmark(size_t count) {
+    auto report = [count](const char* label, std::chrono::steady_clock::time_point start, long long checksum) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << ms << " ms, " << count / ms / 1000 << " M items/s (checksum " << checksum << ")"
+                  << std::endl;
+    };
 
-    void pop() {
-        if (!items.empty()) {
+    std::cout << "=== Fill and drain, " << count << " ints ===" << std::endl;
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::queue<int> items;
+        for (size_t i = 0; i < count; ++i) items.push(static_cast<int>(i));
+        long long sum = 0;
+        for (; !items.empty(); items.pop()) sum += items.front();
+        report("std::queue", start, sum);
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        Queue<int> items;
+        for (size_t i = 0; i < count; ++i) items.push(static_cast<int>(i));
+        long long sum = 0;
+        for (int item; items.try_pop(item);) sum += item;
+        report("Queue     ", start, sum);
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        Queue<int> items(count);
+        for (size_t i = 0; i < count; ++i) items.push(static_cast<int>(i));
+        long long sum = 0;
+        for (int item; items.try_pop(item);) sum += item;
+        report("Queue(count)", start, sum);
+    }
+
+    std::cout << "=== Sliding window of 64 strings, " << count << " push/pop pairs ===" << std::endl;
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::queue<std::string> items;
+        for (int i = 0; i < 64; ++i) items.push("Goblin");
+        long long sum = 0;
+        for (size_t i = 0; i < count; ++i) {
+            items.push("Goblin");
+            sum += static_cast<long long>(items.front().size());
             items.pop();
         }
+        report("std::queue", start, sum);
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        Queue<std::string> items;
+        for (int i = 0; i < 64; ++i) items.emplace("Goblin");
+        long long sum = 0;
+        std::string item;
+        for (size_t i = 0; i < count; ++i) {
+            items.emplace("Goblin");
+            items.try_pop(item);
+            sum += static_cast<long long>(item.size());
+        }
+        report("Queue     ", start, sum);
+    }
+
+    // Старый display копировал всю очередь, новый обходит её на месте
+    std::cout << "=== Walk over " << count << " queued ints ===" << std::endl;
+    {
+        std::queue<int> items;
+        for (size_t i = 0; i < count; ++i) items.push(static_cast<int>(i));
+        auto start = std::chrono::steady_clock::now();
+        std::queue<int> temp = items;
+        long long sum = 0;
+        for (; !temp.empty(); temp.pop()) sum += temp.front();
+        report("std::queue copy", start, sum);
+    }
+    {
+        Queue<int> items;
+        for (size_t i = 0; i < count; ++i) items.push(static_cast<int>(i));
+        auto start = std::chrono::steady_clock::now();
+        long long sum = 0;
+        for (int item : items) sum += item;
+        report("Queue iteration", start, sum);
     }
 
-    void display() const {
-        std::queue<T> temp = items;
-        while (!temp.empty()) {
-            std::cout << temp.front() << " ";
-            temp.pop();
+    // Производитель кладёт count чисел, потребитель забирает; на полной или пустой очереди — yield
+    std::cout << "=== Hand-off between two threads, " << count << " ints ===" << std::endl;
+    auto handOff = [&](const char* label, auto& queue) {
+        auto start = std::chrono::steady_clock::now();
+        std::thread producer([&queue, count] {
+            for (size_t i = 0; i < count; ++i) {
+                while (!queue.try_push(static_cast<int>(i))) std::this_thread::yield();
+            }
+        });
+        long long sum = 0;
+        for (size_t received = 0; received < count;) {
+            int item;
+            if (queue.try_pop(item)) {
+                sum += item;
+                ++received;
+            } else {
+                std::this_thread::yield();
+            }
         }
-        std::cout << std::endl;
+        producer.join();
+        report(label, start, sum);
+    };
+    {
+        LockedQueue<int> queue;
+        handOff("std::queue + mutex", queue);
+    }
+    {
+        SpscQueue<int> queue(1024);
+        handOff("SpscQueue         ", queue);
+    }
+}
+
+// Самопроверка Queue; false — хотя бы одна проверка не прошла
+bool runQueueSelfTest() {
+    bool passed = true;
+    auto check = [&passed](bool condition, const std::string& what) {
+        std::cout << (condition ? "  ok      " : "  FAILED  ") << what << std::endl;
+        passed = passed && condition;
+    };
+    auto contents = [](const Queue<std::string>& queue) {
+        std::string all;
+        for (const std::string& item : queue) all += item + ";";
+        return all;
+    };
+    // Строки длиннее буфера SSO, чтобы чтение освобождённой памяти не прошло незаметно
+    auto word = [](size_t i) { return std::string(32, static_cast<char>('a' + i)); };
+
+    std::cout << "=== Queue ===" << std::endl;
+    Queue<std::string> full;
+    for (size_t i = 0; i < 8; ++i) full.push(word(i));
+    std::string expected = contents(full) + word(0) + ";";
+    full.push(full.front());
+    check(full.size() == 9 && contents(full) == expected, "push(front()) into a full queue grows and copies the element");
+
+    Queue<std::string> wrapped;
+    for (size_t i = 0; i < 8; ++i) wrapped.push(word(i));
+    for (size_t i = 0; i < 3; ++i) wrapped.pop();
+    for (size_t i = 8; i < 11; ++i) wrapped.push(word(i));
+    const std::string& last = *std::next(wrapped.begin(), 7);
+    expected = contents(wrapped) + last + ";";
+    wrapped.emplace(last);
+    check(wrapped.size() == 9 && contents(wrapped) == expected, "emplace(last element) into a full wrapped queue");
+
+    Queue<std::string> moved;
+    for (size_t i = 0; i < 8; ++i) moved.push(word(i));
+    moved.push(std::move(moved.front()));
+    check(moved.size() == 9 && *std::next(moved.begin(), 8) == word(0), "push(std::move(front())) into a full queue");
+
+    Queue<std::string> copy(full);
+    check(contents(copy) == contents(full), "copy keeps order");
+
+    Queue<int> empty;
+    empty.pop();
+    bool threw = false;
+    try {
+        empty.front();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    check(threw && empty.empty(), "pop() of an empty queue is ignored, front() throws");
+
+    std::cout << (passed ? "All checks passed" : "SOME CHECKS FAILED") << std::endl;
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    // Самопроверка очереди; код возврата 1 — есть ошибки
+    if (argc > 1 && std::strcmp(argv[1], "--selftest") == 0) {
+        return runQueueSelfTest() ? 0 : 1;
+    }
+
+    // Замер очередей: --bench [число элементов]; число — целиком цифры и больше нуля
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        size_t count = 10000000;
+        if (argc > 2) {
+            const char* end = argv[2] + std::strlen(argv[2]);
+            auto [ptr, error] = std::from_chars(argv[2], end, count);
+            if (error != std::errc() || ptr != end || count == 0) {
+                std::cerr << "Usage: " << argv[0] << " --bench [count]" << std::endl;
+                return 1;
+            }
+        }
+        runQueueBenchmark(count);
+        return 0;
     }
-};
 
-int main() {
     // Пример работы GameManager (с умными указателями)
     GameManager<std::unique_ptr<Entity>> manager;
     manager.addEntity(std::make_unique<Player>("Hero", 100, 1));
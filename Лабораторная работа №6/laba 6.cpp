@@ -1,11 +1,16 @@
 #include <iostream>
 #include <vector>
-#include <queue>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../common/lifetime.h"
+#include "../common/ring_queue.h"
 
 // Базовый класс Entity
 class Entity {
+    LIFETIME_TRACKED(Entity)
 public:
     virtual ~Entity() = default;
     virtual void displayInfo() const = 0;
@@ -16,6 +21,7 @@ class Player : public Entity {
     std::string name;
     int health;
     int level;
+    LIFETIME_TRACKED(Player)
 
 public:
     Player(const std::string& n, int h, int l) : name(n), health(h), level(l) {}
@@ -29,6 +35,7 @@ class Enemy : public Entity {
     std::string name;
     int health;
     std::string type;
+    LIFETIME_TRACKED(Enemy)
 
 public:
     Enemy(const std::string& n, int h, const std::string& t) : name(n), health(h), type(t) {}
@@ -45,11 +52,12 @@ private:
     std::vector<T> entities;
 
 public:
-    void addEntity(const T& entity) {
+    // По значению: копируемые указатели копируются, unique_ptr передаётся перемещением
+    void addEntity(T entity) {
         if (entity->getHealth() <= 0) {
             throw std::invalid_argument("Entity has invalid health (HP <= 0)");
         }
-        entities.push_back(entity);
+        entities.push_back(std::move(entity));
     }
 
     void displayAll() const {
@@ -59,37 +67,10 @@ public:
     }
 };
 
-// Шаблонный класс Queue с обработкой исключений
+// Шаблонный класс Queue с обработкой исключений: кольцевой буфер из common/ring_queue.h;
+// pop(), front() и display() пустой очереди бросают std::runtime_error
 template <typename T>
-class Queue {
-private:
-    std::queue<T> items;
-
-public:
-    void push(const T& item) {
-        items.push(item);
-    }
-
-    void pop() {
-        if (items.empty()) {
-            throw std::runtime_error("Cannot pop from empty queue");
-        }
-        items.pop();
-    }
-
-    void display() const {
-        if (items.empty()) {
-            throw std::runtime_error("Queue is empty");
-        }
-        
-        std::queue<T> temp = items;
-        while (!temp.empty()) {
-            std::cout << temp.front() << " ";
-            temp.pop();
-        }
-        std::cout << std::endl;
-    }
-};
+using Queue = RingQueue<T, OnEmptyQueue::Throw>;
 
 int main() {
     // Тестирование GameManager с исключениями
@@ -4,17 +4,422 @@
 #include <string>
 #include <stdexcept>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <string_view>
+#include <charconv>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <filesystem>
+#include <array>
+#include <limits>
+#include <iterator>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+#include "../common/lifetime.h"
+#include "../common/lz_frames.h"
+#include "../common/type_registry.h"
 
+// Счётчик выделений в куче для замеров. Выключен по умолчанию: при сборке с
+// -DCOUNT_HEAP_ALLOCATIONS=1 глобальный operator new заменяется обёрткой над malloc,
+// и --bench дополнительно печатает число выделений.
+#ifndef COUNT_HEAP_ALLOCATIONS
+#define COUNT_HEAP_ALLOCATIONS 0
+#endif
+
+#if COUNT_HEAP_ALLOCATIONS
+std::atomic<size_t> heapAllocations{0};
+
+// Замена не встраивается: иначе GCC видит malloc/free в паре с new/delete и предупреждает (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+#define HEAP_NOINLINE __attribute__((noinline))
+#else
+#define HEAP_NOINLINE
+#endif
+
+HEAP_NOINLINE void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+HEAP_NOINLINE void operator delete(void* memory) noexcept { std::free(memory); }
+HEAP_NOINLINE void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+#endif
+
+// ===== Двоичный формат сохранения =====
+// Заголовок: "GMSV" и версия схемы (varint). Дальше блоки: число сущностей (varint),
+// размер данных (varint), данные и CRC32 данных (4 байта, little-endian);
+// блок без сущностей завершает файл, поэтому обрезанный файл не примется за целый.
+// Сущность: тег типа (1 байт), имя (длина varint + байты), здоровье и уровень (zigzag varint),
+// затем поля типа: опыт игрока (zigzag varint) или тип врага (строка).
+
+// Compressed — строки текстового сохранения в сжатых кадрах (см. CompressedWriter)
+enum class SaveFormat { Text, Binary, Compressed };
+
+namespace savefmt {
+
+constexpr char kMagic[4] = {'G', 'M', 'S', 'V'};
+constexpr char kDeltaMagic[4] = {'G', 'M', 'D', 'L'};
+constexpr uint64_t kVersion = 1;
+constexpr size_t kBlockBytes = 64 * 1024;
+
+enum Tag : uint8_t { TagPlayer = 1, TagEnemy = 2 };
+
+// CRC32, varint и запись чисел — те же, что у сжатых кадров (common/lz_frames.h)
+using lzfile::crc32;
+using lzfile::putFixed32;
+using lzfile::putVarint;
+
+inline void putInt(std::string& out, int value) {
+    uint32_t bits = static_cast<uint32_t>(value);
+    putVarint(out, (bits << 1) ^ (value < 0 ? 0xFFFFFFFFu : 0u));
+}
+
+inline void putString(std::string& out, std::string_view text) {
+    putVarint(out, text.size());
+    out.append(text.data(), text.size());
+}
+
+// Десятичная запись числа прямо в конец буфера, без временных строк
+inline void appendInt(std::string& out, int value) {
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+// Число в поле целиком: без пробелов и хвоста, в пределах int; false — поле не число
+inline bool parseInt(std::string_view field, int& value) {
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return error == std::errc() && end == field.data() + field.size();
+}
+
+// Ровно count полей через запятую; false — полей другое число
+inline bool splitFields(std::string_view line, std::string_view* fields, size_t count) {
+    for (size_t i = 0; i + 1 < count; ++i) {
+        size_t comma = line.find(',');
+        if (comma == std::string_view::npos) return false;
+        fields[i] = line.substr(0, comma);
+        line.remove_prefix(comma + 1);
+    }
+    if (line.find(',') != std::string_view::npos) return false;
+    fields[count - 1] = line;
+    return true;
+}
+
+// Имя или тип сущности годится для строки текстового сохранения: без запятых, переводов
+// строк и других управляющих байтов. Такие значения не принимаются нигде (конструкторы,
+// setType, разбор текста, decode), поэтому любое состояние можно сохранить текстом и
+// прочитать обратно, а текстовое сохранение не спутать с двоичным (см. hasSignature).
+inline bool isTextField(std::string_view field) {
+    for (char c : field) {
+        if (c == ',' || static_cast<unsigned char>(c) < 0x20) return false;
+    }
+    return true;
+}
+
+inline std::string_view checkTextField(std::string_view field) {
+    if (!isTextField(field)) {
+        throw std::runtime_error("Entity name or type contains ',' or a control character");
+    }
+    return field;
+}
+
+// Чтение с проверкой границ; любое нарушение формата — исключение
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data(data) {}
+
+    bool atEnd() const { return pos == data.size(); }
+
+    uint8_t byte() { return static_cast<uint8_t>(bytes(1)[0]); }
+
+    std::string_view bytes(size_t count) {
+        if (count > data.size() - pos) throw std::runtime_error("Save file is truncated");
+        std::string_view result = data.substr(pos, count);
+        pos += count;
+        return result;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        throw std::runtime_error("Invalid varint in save file");
+    }
+
+    int integer() {
+        uint64_t raw = varint();
+        if (raw > 0xFFFFFFFFu) throw std::runtime_error("Invalid number in save file");
+        uint32_t bits = static_cast<uint32_t>(raw);
+        return static_cast<int>((bits >> 1) ^ (0u - (bits & 1)));
+    }
+
+    uint32_t fixed32() {
+        std::string_view raw = bytes(4);
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<uint8_t>(raw[i])) << (8 * i);
+        return value;
+    }
+
+    std::string_view string() { return bytes(static_cast<size_t>(varint())); }
+
+    std::string_view rest() const { return data.substr(pos); }
+
+    size_t offset() const { return pos; }
+    std::string_view since(size_t start) const { return data.substr(start, pos - start); }
+
+private:
+    std::string_view data;
+    size_t pos = 0;
+};
+
+// Заголовок файла: сигнатура и версия схемы
+inline void putHeader(std::string& out, const char (&magic)[4]) {
+    out.append(magic, sizeof(magic));
+    putVarint(out, kVersion);
+}
+
+inline void readHeader(Reader& in, const char (&magic)[4]) {
+    if (in.bytes(sizeof(magic)) != std::string_view(magic, sizeof(magic))) {
+        throw std::runtime_error("Unexpected file signature");
+    }
+    uint64_t version = in.varint();
+    if (version == 0 || version > kVersion) {
+        throw std::runtime_error("Unsupported save file version " + std::to_string(version));
+    }
+}
+
+// Блок: число записей, размер, данные и CRC. Ошибка CRC — исключение.
+inline void readBlock(Reader& in, uint64_t& count, std::string_view& payload) {
+    count = in.varint();
+    payload = in.bytes(static_cast<size_t>(in.varint()));
+    if (in.fixed32() != crc32(payload)) {
+        throw std::runtime_error("Save file block checksum mismatch");
+    }
+}
+
+// Накопление записей в блоки; блок уходит в поток, когда данных набирается больше blockBytes
+class BlockWriter {
+public:
+    explicit BlockWriter(std::ostream& out, size_t blockBytes = kBlockBytes) : out(out), blockBytes(blockBytes) {}
+
+    std::string& payload() { return block; }
+
+    void endRecord() {
+        ++count;
+        if (block.size() >= blockBytes) flush();
+    }
+
+    void flush() {
+        if (count > 0) writeBlock();
+    }
+
+    // Остаток и завершающий пустой блок
+    void finish() {
+        flush();
+        writeBlock();
+    }
+
+private:
+    void writeBlock() {
+        frame.clear();
+        putVarint(frame, count);
+        putVarint(frame, block.size());
+        frame += block;
+        putFixed32(frame, crc32(block));
+        out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+        block.clear();
+        count = 0;
+    }
+
+    std::ostream& out;
+    size_t blockBytes;
+    std::string block;
+    std::string frame;
+    size_t count = 0;
+};
+
+// ===== Сжатое текстовое сохранение =====
+// Строки текстового формата в сжатых кадрах lzfile (common/lz_frames.h; тот же формат пишет
+// журнал лабораторной 9). Кадр режется по границе строки, поэтому каждый распаковывается и
+// разбирается отдельно, а по числу строк в заголовках можно перейти к нужной строке, не
+// распаковывая предыдущие. Кадр без строк завершает файл; файл без него считается обрезанным.
+constexpr const auto& kCompressedMagic = lzfile::kMagic;
+constexpr size_t kCompressedBlockBytes = lzfile::kFrameBytes;
+static_assert(kVersion == lzfile::kVersion, "compressed saves share the lzfile header");
+
+class CompressedWriter {
+public:
+    explicit CompressedWriter(std::ostream& out, size_t blockBytes = kCompressedBlockBytes)
+        : out(out), blockBytes(blockBytes) {}
+
+    std::string& text() { return block; }
+
+    void endLine() {
+        ++lines;
+        if (block.size() >= blockBytes) flush();
+    }
+
+    void flush() {
+        if (lines > 0) writeFrame();
+    }
+
+    // Остаток и завершающий пустой кадр
+    void finish() {
+        flush();
+        writeFrame();
+    }
+
+private:
+    void writeFrame() {
+        lzfile::writeFrame(out, block, lines, packed, table);
+        block.clear();
+        lines = 0;
+    }
+
+    std::ostream& out;
+    size_t blockBytes;
+    std::string block;
+    std::string packed;
+    std::vector<uint32_t> table;
+    size_t lines = 0;
+};
+
+using CompressedFrame = lzfile::Frame;
+
+// Заголовок и данные кадра без распаковки
+inline CompressedFrame readFrame(Reader& in) {
+    CompressedFrame frame;
+    size_t length = lzfile::parseFrame(in.rest(), frame);
+    if (length == 0) {
+        throw std::runtime_error("Save file is truncated");
+    }
+    in.bytes(length);
+    return frame;
+}
+
+// Исходный текст кадра в out; ошибка CRC — исключение
+inline void unpackFrame(const CompressedFrame& frame, std::string& out) {
+    out.resize(frame.size);
+    lzfile::unpackFrame(frame, out.data());
+}
+
+// Сигнатура и следующий за ней байт версии. Версия меньше 0x20, то есть управляющий байт,
+// а в тексте сохранения их не бывает (checkTextField): текстовое сохранение, где имя первой
+// сущности начинается с "GMSV", по-прежнему читается как текст.
+static_assert(kVersion < 0x20, "the version byte must stay a control character");
+
+inline bool hasSignature(std::string_view data, const char (&magic)[4]) {
+    return data.size() > sizeof(magic) && data.compare(0, sizeof(magic), std::string_view(magic, sizeof(magic))) == 0 &&
+           static_cast<unsigned char>(data[sizeof(magic)]) < 0x20;
+}
+
+inline bool fileHasSignature(const std::string& filename, const char (&magic)[4]) {
+    std::ifstream file(filename, std::ios::binary);
+    char head[sizeof(magic) + 1] = {};
+    file.read(head, sizeof(head));
+    return file.gcount() == sizeof(head) && hasSignature(std::string_view(head, sizeof(head)), magic);
+}
+
+inline bool isBinary(std::string_view data) { return hasSignature(data, kMagic); }
+inline bool isBinaryFile(const std::string& filename) { return fileHasSignature(filename, kMagic); }
+inline bool isCompressed(std::string_view data) { return hasSignature(data, kCompressedMagic); }
+inline bool isCompressedFile(const std::string& filename) { return fileHasSignature(filename, kCompressedMagic); }
+
+// Файл целиком в строку
+inline std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open file for reading.");
+    }
+    std::string data(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return data;
+}
+
+}  // namespace savefmt
+
+class Entity;
+
+// Наблюдатель за сущностью: вызывается перед каждым изменением её полей
+class EntityObserver {
+public:
+    virtual ~EntityObserver() {}
+    virtual void beforeChange(Entity& entity) = 0;
+};
+
+// Сущности хранят строки в std::pmr::string: в режиме арены имя и тип лежат
+// в той же памяти уровня, что и сам объект
 class Entity {
+    template<typename> friend class GameManager;
+
+    // Служебные поля менеджера: номер в менеджере, отметка об изменении с прошлого сохранения
+    // и номер снимка, для которого старое состояние уже сохранено
+    EntityObserver* observer = nullptr;
+    uint32_t slot = 0;
+    bool dirty = false;
+    uint32_t snapshotEpoch = 0;
+
 protected:
-    std::string name;
+    std::pmr::string name;
     int health;
     int level;
 
+    // Все изменения полей проходят через touch(), чтобы менеджер мог их учесть
+    void touch() {
+        if (observer) observer->beforeChange(*this);
+    }
+
+    // Общие поля из разделённой строки. Числа проверяются до присваивания:
+    // false — объект не изменился.
+    bool assignFields(std::string_view newName, std::string_view newHealth, std::string_view newLevel) {
+        int parsedHealth = 0;
+        int parsedLevel = 0;
+        if (!savefmt::isTextField(newName) || !savefmt::parseInt(newHealth, parsedHealth) ||
+            !savefmt::parseInt(newLevel, parsedLevel)) {
+            return false;
+        }
+        touch();
+        name = newName;
+        health = parsedHealth;
+        level = parsedLevel;
+        return true;
+    }
+    LIFETIME_TRACKED(Entity)
+
 public:
+    using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+    Entity(std::allocator_arg_t, const allocator_type& alloc, std::string_view name = {}, int health = 0,
+           int level = 0)
+        : name(savefmt::checkTextField(name), alloc), health(health), level(level) {}
+
     Entity(const std::string& name, int health, int level)
-        : name(name), health(health), level(level) {}
+        : Entity(std::allocator_arg, allocator_type(), name, health, level) {}
 
     virtual ~Entity() {}
 
@@ -22,161 +427,2494 @@ public:
         std::cout << "Name: " << name << ", Health: " << health << ", Level: " << level;
     }
 
-    std::string getName() const { return name; }
+    std::string getName() const { return std::string(name); }
     int getHealth() const { return health; }
     int getLevel() const { return level; }
+    bool isDirty() const { return dirty; }
+
+    void setHealth(int value) {
+        touch();
+        health = value;
+    }
+
+    void setLevel(int value) {
+        touch();
+        level = value;
+    }
 
     virtual std::string serialize() const {
-        return name + "," + std::to_string(health) + "," + std::to_string(level);
+        std::string out;
+        serializeTo(out);
+        return out;
+    }
+
+    // Текстовая запись в конец переданного буфера; буфер можно переиспользовать между сущностями
+    virtual void serializeTo(std::string& out) const {
+        out.append(name.data(), name.size());
+        out.push_back(',');
+        savefmt::appendInt(out, health);
+        out.push_back(',');
+        savefmt::appendInt(out, level);
+    }
+
+    // Двоичная запись: производный класс пишет тег, затем общие поля, затем свои
+    virtual void encode(std::string& out) const {
+        savefmt::putString(out, name);
+        savefmt::putInt(out, health);
+        savefmt::putInt(out, level);
+    }
+
+    // Чтение полей, записанных encode() после тега
+    virtual void decode(savefmt::Reader& in) {
+        touch();
+        name = savefmt::checkTextField(in.string());
+        health = in.integer();
+        level = in.integer();
     }
 
+    // Строка "имя,здоровье,уровень". Плохая строка — std::runtime_error, объект не меняется.
     virtual void deserialize(const std::string& data) {
-        size_t pos1 = data.find(',');
-        size_t pos2 = data.find(',', pos1 + 1);
-        
-        if (pos1 == std::string::npos || pos2 == std::string::npos) {
+        std::string_view fields[3];
+        if (!savefmt::splitFields(data, fields, 3) || !assignFields(fields[0], fields[1], fields[2])) {
             throw std::runtime_error("Invalid data format");
         }
-        
-        name = data.substr(0, pos1);
-        health = std::stoi(data.substr(pos1 + 1, pos2 - pos1 - 1));
-        level = std::stoi(data.substr(pos2 + 1));
     }
 };
 
 
+// arena == nullptr — обычный new; иначе объект и его строки размещаются в arena
+template<typename E, typename... Args>
+E* constructEntity(std::pmr::memory_resource* arena, Args&&... args) {
+    if (!arena) {
+        return new E(std::allocator_arg, Entity::allocator_type(), std::forward<Args>(args)...);
+    }
+    void* memory = arena->allocate(sizeof(E), alignof(E));
+    return new (memory) E(std::allocator_arg, Entity::allocator_type(arena), std::forward<Args>(args)...);
+}
+
+// Парная к constructEntity: память арены не возвращается, только вызывается деструктор
+inline void destroyEntity(Entity* entity, std::pmr::memory_resource* arena) {
+    if (arena) {
+        entity->~Entity();
+    } else {
+        delete entity;
+    }
+}
+
+// ===== Реестр типов сущностей =====
+// Тип регистрирует себя макросом REGISTER_ENTITY: текстовый тег (последнее поле строки
+// сохранения), однобайтовый тег двоичного формата и фабрику пустого объекта, который потом
+// заполняют deserialize() или decode(). Загрузчики находят тип только через реестр, поэтому
+// новый тип загружается без правки загрузчиков.
+// Поиск по двоичному тегу — индекс в массиве, по текстовому — совершенный хеш TypeRegistry.
+class EntityRegistry {
+public:
+    using Factory = Entity* (*)(std::pmr::memory_resource* arena);
+    using Skip = void (*)(savefmt::Reader& in);
+
+    struct Type {
+        std::string_view tag;
+        uint8_t code = 0;
+        Factory make = nullptr;
+        Skip skip = nullptr;
+    };
+
+    static EntityRegistry& instance() {
+        static EntityRegistry registry;
+        return registry;
+    }
+
+    template<typename E>
+    bool add(std::string_view tag, uint8_t code) {
+        if (byCode(code) || byTag(tag)) {
+            throw std::logic_error("Entity type is already registered");
+        }
+        Type type;
+        type.tag = tag;
+        type.code = code;
+        type.make = [](std::pmr::memory_resource* arena) -> Entity* { return constructEntity<E>(arena); };
+        type.skip = [](savefmt::Reader& in) {
+            std::array<std::byte, 512> buffer;
+            std::pmr::monotonic_buffer_resource local(buffer.data(), buffer.size());
+            E entity(std::allocator_arg, Entity::allocator_type(&local));
+            entity.decode(in);
+        };
+        tags.add(tag, type);
+        codes[code] = type;
+        return true;
+    }
+
+    const Type* byTag(std::string_view tag) const { return tags.find(tag); }
+
+    const Type* byCode(uint8_t code) const {
+        return codes[code].make ? &codes[code] : nullptr;
+    }
+
+    // Пустой объект типа с двоичным тегом code, заполненный из in; при ошибке объект уничтожается
+    Entity* decode(uint8_t code, savefmt::Reader& in, std::pmr::memory_resource* arena) const {
+        const Type* type = byCode(code);
+        if (!type) {
+            throw std::runtime_error("Unknown entity tag in save file");
+        }
+        Entity* entity = type->make(arena);
+        try {
+            entity->decode(in);
+        } catch (...) {
+            destroyEntity(entity, arena);
+            throw;
+        }
+        return entity;
+    }
+
+    // Запись сущности целиком (тег и поля) как непрерывный кусок данных
+    std::string_view readRecord(savefmt::Reader& in) const {
+        size_t start = in.offset();
+        const Type* type = byCode(in.byte());
+        if (!type) {
+            throw std::runtime_error("Unknown entity tag in save file");
+        }
+        type->skip(in);
+        return in.since(start);
+    }
+
+private:
+    TypeRegistry<Entity, Type> tags;
+    std::array<Type, 256> codes{};
+};
+
+#define REGISTER_ENTITY(Type, tag, code) \
+    static const bool Type##Registered = EntityRegistry::instance().add<Type>(tag, code)
+
 class Player : public Entity {
 private:
     int experience;
+    LIFETIME_TRACKED(Player)
 
 public:
+    Player(std::allocator_arg_t, const allocator_type& alloc, std::string_view name = {}, int health = 0,
+           int level = 0, int exp = 0)
+        : Entity(std::allocator_arg, alloc, name, health, level), experience(exp) {}
+
     Player(const std::string& name, int health, int level, int exp = 0)
-        : Entity(name, health, level), experience(exp) {}
+        : Player(std::allocator_arg, allocator_type(), name, health, level, exp) {}
 
     void display() const override {
         Entity::display();
         std::cout << ", Experience: " << experience << std::endl;
     }
 
-    std::string serialize() const override {
-        return Entity::serialize() + "," + std::to_string(experience) + ",Player";
+    int getExperience() const { return experience; }
+
+    void setExperience(int value) {
+        touch();
+        experience = value;
+    }
+
+    void serializeTo(std::string& out) const override {
+        Entity::serializeTo(out);
+        out.push_back(',');
+        savefmt::appendInt(out, experience);
+        out.append(",Player");
+    }
+
+    void encode(std::string& out) const override {
+        out.push_back(static_cast<char>(savefmt::TagPlayer));
+        Entity::encode(out);
+        savefmt::putInt(out, experience);
+    }
+
+    void decode(savefmt::Reader& in) override {
+        Entity::decode(in);
+        experience = in.integer();
     }
 
+    // Строка сохранения целиком: имя,здоровье,уровень,опыт,Player
     void deserialize(const std::string& data) override {
-        size_t pos1 = data.find(',');
-        size_t pos2 = data.find(',', pos1 + 1);
-        size_t pos3 = data.find(',', pos2 + 1);
-        size_t pos4 = data.find(',', pos3 + 1);
-        
-        if (pos1 == std::string::npos || pos2 == std::string::npos || 
-            pos3 == std::string::npos || pos4 == std::string::npos) {
+        std::string_view fields[5];
+        int parsedExperience = 0;
+        if (!savefmt::splitFields(data, fields, 5) || fields[4] != "Player" ||
+            !savefmt::parseInt(fields[3], parsedExperience) || !assignFields(fields[0], fields[1], fields[2])) {
             throw std::runtime_error("Invalid data format for Player");
         }
-        
-        Entity::deserialize(data.substr(0, pos3));
-        experience = std::stoi(data.substr(pos3 + 1, pos4 - pos3 - 1));
+        experience = parsedExperience;
     }
 };
 
+REGISTER_ENTITY(Player, "Player", savefmt::TagPlayer);
+
 class Enemy : public Entity {
 private:
-    std::string type;
+    std::pmr::string type;
+    LIFETIME_TRACKED(Enemy)
 
 public:
+    Enemy(std::allocator_arg_t, const allocator_type& alloc, std::string_view name = {}, int health = 0,
+          int level = 0, std::string_view type = {})
+        : Entity(std::allocator_arg, alloc, name, health, level), type(savefmt::checkTextField(type), alloc) {}
+
     Enemy(const std::string& name, int health, int level, const std::string& type)
-        : Entity(name, health, level), type(type) {}
+        : Enemy(std::allocator_arg, allocator_type(), name, health, level, type) {}
 
     void display() const override {
         Entity::display();
         std::cout << ", Type: " << type << std::endl;
     }
 
-    std::string serialize() const override {
-        return Entity::serialize() + "," + type + ",Enemy";
+    std::string getType() const { return std::string(type); }
+
+    void setType(std::string_view value) {
+        savefmt::checkTextField(value);
+        touch();
+        type = value;
+    }
+
+    void serializeTo(std::string& out) const override {
+        Entity::serializeTo(out);
+        out.push_back(',');
+        out.append(type.data(), type.size());
+        out.append(",Enemy");
+    }
+
+    void encode(std::string& out) const override {
+        out.push_back(static_cast<char>(savefmt::TagEnemy));
+        Entity::encode(out);
+        savefmt::putString(out, type);
     }
 
+    void decode(savefmt::Reader& in) override {
+        Entity::decode(in);
+        type = savefmt::checkTextField(in.string());
+    }
+
+    // Строка сохранения целиком: имя,здоровье,уровень,тип,Enemy
     void deserialize(const std::string& data) override {
-        size_t pos1 = data.find(',');
-        size_t pos2 = data.find(',', pos1 + 1);
-        size_t pos3 = data.find(',', pos2 + 1);
-        size_t pos4 = data.find(',', pos3 + 1);
-        
-        if (pos1 == std::string::npos || pos2 == std::string::npos || 
-            pos3 == std::string::npos || pos4 == std::string::npos) {
+        std::string_view fields[5];
+        if (!savefmt::splitFields(data, fields, 5) || fields[4] != "Enemy" || !savefmt::isTextField(fields[3]) ||
+            !assignFields(fields[0], fields[1], fields[2])) {
             throw std::runtime_error("Invalid data format for Enemy");
         }
-        
-        Entity::deserialize(data.substr(0, pos3));
-        type = data.substr(pos3 + 1, pos4 - pos3 - 1);
+        type = fields[3];
     }
 };
 
-template<typename T>
-class GameManager {
-private:
-    std::vector<T> entities;
+REGISTER_ENTITY(Enemy, "Enemy", savefmt::TagEnemy);
+
+// ===== Загрузка сохранения через отображение файла в память =====
+// Файл отображается целиком, строки и поля разбираются как string_view без копий,
+// числа — через std::from_chars; сущности строятся прямо из разобранных полей.
 
+class MappedFile {
 public:
-    void addEntity(T entity) {
-        entities.push_back(entity);
+    explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open file for reading.");
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            data = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            if (!data) {
+                close();
+                throw std::runtime_error("Failed to map file.");
+            }
+        }
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file for reading.");
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            close();
+            throw std::runtime_error("Failed to stat file.");
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close();
+                throw std::runtime_error("Failed to map file.");
+            }
+            data = static_cast<const char*>(mapped);
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+#endif
     }
 
-    void displayAll() const {
-        for (const auto& entity : entities) {
-            entity->display();
-        }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view view() const { return std::string_view(data, length); }
+
+private:
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) ::munmap(const_cast<char*>(data), length);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
     }
 
-    void saveToFile(const std::string& filename) const {
-        std::ofstream file(filename);
-        if (!file) {
-            throw std::runtime_error("Failed to open file for writing.");
-        }
+    const char* data = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
 
-        for (const auto& entity : entities) {
-            file << entity->serialize() << "\n";
-        }
+enum class SaveKind { Player, Enemy };
+
+// Поля одной строки сохранения; строковые поля указывают в отображённый файл
+struct SaveRecord {
+    SaveKind kind;
+    std::string_view name;
+    int health;
+    int level;
+    int experience;
+    std::string_view type;
+};
+
+// Формат тот же, что у serialize(): имя,здоровье,уровень,опыт|тип,Player|Enemy.
+// false — строка без известного типа; она пропускается, как и при чтении через getline.
+// Строка известного типа с другим числом полей или неверным числом — std::runtime_error;
+// правила те же, что у deserialize().
+inline bool parseSaveLine(std::string_view line, SaveRecord& record) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    size_t lastComma = line.rfind(',');
+    if (lastComma == std::string_view::npos) return false;
+
+    std::string_view tag = line.substr(lastComma + 1);
+    if (tag == "Player") {
+        record.kind = SaveKind::Player;
+    } else if (tag == "Enemy") {
+        record.kind = SaveKind::Enemy;
+    } else {
+        return false;
     }
 
-    void loadFromFile(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file) {
-            throw std::runtime_error("Failed to open file for reading.");
+    auto invalid = [&record] {
+        return std::runtime_error(record.kind == SaveKind::Player ? "Invalid data format for Player"
+                                                                  : "Invalid data format for Enemy");
+    };
+
+    // Четвёртая запятая обязана быть той, что перед тегом: иначе полей больше пяти
+    size_t pos[4];
+    size_t from = 0;
+    for (size_t& p : pos) {
+        p = line.find(',', from);
+        if (p == std::string_view::npos) throw invalid();
+        from = p + 1;
+    }
+    if (pos[3] != lastComma) throw invalid();
+
+    record.name = line.substr(0, pos[0]);
+    std::string_view fourth = line.substr(pos[2] + 1, pos[3] - pos[2] - 1);
+    if (!savefmt::isTextField(record.name) || (record.kind == SaveKind::Enemy && !savefmt::isTextField(fourth)) ||
+        !savefmt::parseInt(line.substr(pos[0] + 1, pos[1] - pos[0] - 1), record.health) ||
+        !savefmt::parseInt(line.substr(pos[1] + 1, pos[2] - pos[1] - 1), record.level) ||
+        (record.kind == SaveKind::Player && !savefmt::parseInt(fourth, record.experience))) {
+        throw invalid();
+    }
+    if (record.kind == SaveKind::Enemy) {
+        record.type = fourth;
+    }
+    return true;
+}
+
+// ===== Индекс текстового сохранения =====
+// После строк сущностей saveToFile дописывает сегмент индекса: строки фиксированной длины
+// "#" + хеш имени (8 hex-цифр) + смещение строки сущности (12 hex-цифр), сначала игроки, потом
+// враги, внутри вида — по хешу. Замыкает сегмент строка-подвал "#F" + начало сегмента, число
+// записей, игроков, врагов и смещение предыдущего подвала (по 16 hex-цифр). В этих строках нет
+// запятых, поэтому обычная загрузка их пропускает.
+// Дозапись добавляет строки сущностей и новый сегмент, ссылающийся на предыдущий подвал;
+// старые смещения при этом не меняются. Строки, дописанные без индекса, идут после последнего
+// подвала и при поиске просматриваются подряд.
+namespace saveindex {
+
+constexpr size_t kHashDigits = 8;
+constexpr size_t kOffsetDigits = 12;
+constexpr size_t kEntryBytes = 1 + kHashDigits + kOffsetDigits + 1;
+constexpr size_t kFooterBytes = 2 + 5 * 16 + 1;
+constexpr uint64_t kNone = ~uint64_t(0);
+
+// FNV-1a, 32 бита; совпадения хешей разрешаются сравнением имени в самой строке
+inline uint32_t nameHash(std::string_view name) { return fnv1a(name); }
+
+// digits — чётное число; по байту за шаг
+inline char* putHex(char* cursor, uint64_t value, size_t digits) {
+    static const auto pairs = [] {
+        std::array<char, 512> table{};
+        for (size_t b = 0; b < 256; ++b) {
+            table[2 * b] = "0123456789abcdef"[b >> 4];
+            table[2 * b + 1] = "0123456789abcdef"[b & 0xF];
         }
+        return table;
+    }();
+    for (size_t i = digits; i > 0; i -= 2, value >>= 8) {
+        std::memcpy(cursor + i - 2, &pairs[2 * (value & 0xFF)], 2);
+    }
+    return cursor + digits;
+}
 
-        entities.clear();
+// false — не ровно text.size() hex-цифр
+inline bool readHex(std::string_view text, uint64_t& value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return error == std::errc() && end == text.data() + text.size();
+}
 
-        std::string line;
-        while (std::getline(file, line)) {
-            size_t lastComma = line.rfind(',');
-            if (lastComma == std::string::npos) {
-                continue;
-            }
+struct Footer {
+    uint64_t indexStart = 0;
+    uint64_t entries = 0;
+    uint64_t players = 0;
+    uint64_t enemies = 0;
+    uint64_t previous = kNone;
+};
 
-            std::string type = line.substr(lastComma + 1);
-            Entity* entity = nullptr;
+// Подвал по смещению at; проверяется и его согласованность с сегментом перед ним
+inline bool readFooter(std::string_view file, uint64_t at, Footer& footer) {
+    if (at > file.size() || file.size() - at < kFooterBytes) return false;
+    std::string_view line = file.substr(static_cast<size_t>(at), kFooterBytes);
+    if (line.compare(0, 2, "#F") != 0 || line.back() != '\n') return false;
+    uint64_t* fields[] = {&footer.indexStart, &footer.entries, &footer.players, &footer.enemies, &footer.previous};
+    for (size_t i = 0; i < 5; ++i) {
+        if (!readHex(line.substr(2 + i * 16, 16), *fields[i])) return false;
+    }
+    return footer.players + footer.enemies == footer.entries && footer.indexStart <= at &&
+           (at - footer.indexStart) % kEntryBytes == 0 && (at - footer.indexStart) / kEntryBytes == footer.entries &&
+           (footer.previous == kNone || footer.previous < footer.indexStart);
+}
 
-            if (type == "Player") {
-                entity = new Player("", 0, 0);
-            } else if (type == "Enemy") {
-                entity = new Enemy("", 0, 0, "");
-            } else {
-                continue;
-            }
+// Запись номер i сегмента с подвалом footer
+inline void readEntry(std::string_view file, const Footer& footer, uint64_t i, uint64_t& hash, uint64_t& offset) {
+    std::string_view entry = file.substr(static_cast<size_t>(footer.indexStart + i * kEntryBytes), kEntryBytes);
+    if (entry[0] != '#' || !readHex(entry.substr(1, kHashDigits), hash) ||
+        !readHex(entry.substr(1 + kHashDigits, kOffsetDigits), offset)) {
+        throw std::runtime_error("Corrupted save index");
+    }
+}
 
-            entity->deserialize(line);
-            entities.push_back(entity);
+// Последний подвал файла (kNone — индекса нет) и начало строк после него
+inline uint64_t findLastFooter(std::string_view file, uint64_t& tailStart) {
+    size_t end = file.size();
+    while (end > 0) {
+        size_t start = end >= 2 ? file.rfind('\n', end - 2) : std::string_view::npos;
+        start = start == std::string_view::npos ? 0 : start + 1;
+        Footer footer;
+        if (end - start == kFooterBytes && readFooter(file, start, footer)) {
+            tailStart = end;
+            return start;
         }
+        end = start;
+    }
+    tailStart = 0;
+    return kNone;
+}
+
+// Сегмент индекса для строк, записанных одним сохранением или дозаписью
+class IndexBuilder {
+public:
+    // line — строка сущности без '\n', offset — её смещение в файле; смещения идут по возрастанию.
+    // Полный разбор не нужен: имя — до первой запятой, вид — после последней.
+    void add(std::string_view line, uint64_t offset) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        size_t lastComma = line.rfind(',');
+        if (lastComma == std::string_view::npos) return;
+        std::string_view tag = line.substr(lastComma + 1);
+        if (tag != "Player" && tag != "Enemy") return;
+        std::vector<Entry>& list = tag == "Player" ? players : enemies;
+        list.push_back({nameHash(line.substr(0, line.find(','))), offset});
     }
 
-    ~GameManager() {
-        for (auto& entity : entities) {
-            delete entity;
+    // Строки сегмента и подвал в поток кусками по kChunkEntries строк;
+    // indexStart — смещение, с которого они лягут в файл
+    void write(std::ostream& out, uint64_t indexStart, uint64_t previous) {
+        char chunk[kChunkEntries * kEntryBytes];
+        for (std::vector<Entry>* list : {&players, &enemies}) {
+            sortByHash(*list);
+            char* cursor = chunk;
+            for (const Entry& entry : *list) {
+                *cursor++ = '#';
+                cursor = putHex(cursor, entry.hash, kHashDigits);
+                cursor = putHex(cursor, entry.offset, kOffsetDigits);
+                *cursor++ = '\n';
+                if (cursor == chunk + sizeof(chunk)) {
+                    out.write(chunk, sizeof(chunk));
+                    cursor = chunk;
+                }
+            }
+            out.write(chunk, cursor - chunk);
+        }
+        char footer[kFooterBytes];
+        char* cursor = footer;
+        *cursor++ = '#';
+        *cursor++ = 'F';
+        for (uint64_t value : {indexStart, uint64_t(players.size() + enemies.size()), uint64_t(players.size()),
+                               uint64_t(enemies.size()), previous}) {
+            cursor = putHex(cursor, value, 16);
+        }
+        *cursor = '\n';
+        out.write(footer, sizeof(footer));
+    }
+
+private:
+    static constexpr size_t kChunkEntries = 2048;
+
+    struct Entry {
+        uint32_t hash;
+        uint64_t offset;
+    };
+
+    // Устойчивая поразрядная сортировка по хешу, 2 прохода по 16 бит (гистограммы обоих
+    // разрядов за один проход): записи с равным хешем остаются в порядке смещений
+    void sortByHash(std::vector<Entry>& list) {
+        scratch.resize(list.size());
+        std::vector<uint32_t> counts(2 << 16);
+        for (const Entry& entry : list) {
+            ++counts[entry.hash & 0xFFFF];
+            ++counts[(1 << 16) + (entry.hash >> 16)];
+        }
+        for (int pass = 0; pass < 2; ++pass) {
+            uint32_t* digit = counts.data() + (pass << 16);
+            uint32_t total = 0;
+            for (size_t d = 0; d < (1 << 16); ++d) {
+                uint32_t current = digit[d];
+                digit[d] = total;
+                total += current;
+            }
+            int shift = pass * 16;
+            for (const Entry& entry : list) scratch[digit[(entry.hash >> shift) & 0xFFFF]++] = entry;
+            list.swap(scratch);
         }
     }
+
+    std::vector<Entry> players;
+    std::vector<Entry> enemies;
+    std::vector<Entry> scratch;
 };
 
-int main() {
+// Строка, начинающаяся со смещения offset, без '\n'
+inline std::string_view lineAt(std::string_view file, uint64_t offset) {
+    if (offset >= file.size()) {
+        throw std::runtime_error("Save index points past the end of file");
+    }
+    std::string_view rest = file.substr(static_cast<size_t>(offset));
+    return rest.substr(0, rest.find('\n'));
+}
+
+// Обход строк без индекса после последнего подвала
+template<typename Visit>
+void forEachTailLine(std::string_view file, uint64_t tailStart, Visit visit) {
+    for (size_t at = static_cast<size_t>(tailStart); at < file.size();) {
+        size_t eol = file.find('\n', at);
+        if (eol == std::string_view::npos) eol = file.size();
+        visit(file.substr(at, eol - at), uint64_t(at));
+        at = eol + 1;
+    }
+}
+
+// Смещение последней записанной строки сущности с именем name; kNone — такой нет.
+// Поиск идёт от новых сегментов к старым: двоичный поиск по хешу в диапазоне каждого вида.
+inline uint64_t findByName(std::string_view file, std::string_view name) {
+    uint64_t tailStart = 0;
+    uint64_t footerAt = findLastFooter(file, tailStart);
+    uint64_t found = kNone;
+    SaveRecord record;
+    forEachTailLine(file, tailStart, [&](std::string_view line, uint64_t at) {
+        if (parseSaveLine(line, record) && record.name == name) found = at;
+    });
+    if (found != kNone) return found;
+
+    uint64_t hash = nameHash(name);
+    Footer footer;
+    for (; footerAt != kNone; footerAt = footer.previous) {
+        if (!readFooter(file, footerAt, footer)) {
+            throw std::runtime_error("Corrupted save index");
+        }
+        std::pair<uint64_t, uint64_t> ranges[] = {{0, footer.players}, {footer.players, footer.entries}};
+        for (auto [first, last] : ranges) {
+            uint64_t low = first;
+            uint64_t high = last;
+            uint64_t entryHash = 0;
+            uint64_t offset = 0;
+            while (low < high) {
+                uint64_t middle = low + (high - low) / 2;
+                readEntry(file, footer, middle, entryHash, offset);
+                if (entryHash < hash) low = middle + 1; else high = middle;
+            }
+            for (; low < last; ++low) {
+                readEntry(file, footer, low, entryHash, offset);
+                if (entryHash != hash) break;
+                if (parseSaveLine(lineAt(file, offset), record) && record.name == name &&
+                    (found == kNone || offset > found)) {
+                    found = offset;
+                }
+            }
+        }
+        if (found != kNone) return found;
+    }
+    return kNone;
+}
+
+// Смещения всех строк сущностей вида kind в порядке файла
+inline std::vector<uint64_t> findByKind(std::string_view file, SaveKind kind) {
+    uint64_t tailStart = 0;
+    uint64_t footerAt = findLastFooter(file, tailStart);
+    std::vector<uint64_t> offsets;
+    Footer footer;
+    for (; footerAt != kNone; footerAt = footer.previous) {
+        if (!readFooter(file, footerAt, footer)) {
+            throw std::runtime_error("Corrupted save index");
+        }
+        uint64_t first = kind == SaveKind::Player ? 0 : footer.players;
+        uint64_t last = kind == SaveKind::Player ? footer.players : footer.entries;
+        for (uint64_t i = first; i < last; ++i) {
+            uint64_t hash = 0;
+            uint64_t offset = 0;
+            readEntry(file, footer, i, hash, offset);
+            offsets.push_back(offset);
+        }
+    }
+    SaveRecord record;
+    forEachTailLine(file, tailStart, [&](std::string_view line, uint64_t at) {
+        if (parseSaveLine(line, record) && record.kind == kind) offsets.push_back(at);
+    });
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+}  // namespace saveindex
+
+// Heap: каждая сущность и её строки выделяются через new и освобождаются по одной.
+// Arena: пул со списками свободных блоков поверх монотонного буфера уровня;
+// выгрузка уровня отдаёт буферы целиком, без обхода сущностей.
+enum class AllocMode { Heap, Arena };
+
+template<typename T>
+class GameManager : private EntityObserver {
+private:
+    std::vector<T> entities;
+    std::vector<bool> heapSlots; // сущность создана через new и удаляется в clear()
+    AllocMode mode;
+    std::pmr::monotonic_buffer_resource levelBuffer;
+    std::pmr::unsynchronized_pool_resource levelPool{&levelBuffer};
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> loadArenas;
+
+    // Журнал изменений: база, лог дельт и номера изменённых сущностей с последнего сохранения
+    std::string journalBase;
+    std::ofstream journalLog;
+    bool journalActive = false;
+    std::vector<uint32_t> dirtySlots;
+    std::thread compactor;
+    std::atomic<bool> compactionDone{true};
+    std::exception_ptr compactionError;
+
+    // Снимок для фонового сохранения. Поток записи идёт по слотам [0, count) пачками под lock;
+    // сущность, которую игра меняет раньше, чем до неё дошла запись, сначала кодируется в preserved.
+    struct Snapshot {
+        std::mutex lock;
+        size_t count = 0;
+        size_t progress = 0;
+        SaveFormat format = SaveFormat::Text;
+        std::unordered_map<uint32_t, std::string> preserved;
+        std::atomic<bool> done{false};
+    };
+    std::unique_ptr<Snapshot> snapshot;
+    std::thread saver;
+    uint32_t snapshotEpoch = 0;
+
+    static constexpr size_t kParallelLoadBytes = 1 << 20;
+    static constexpr size_t kSaveBufferBytes = 1 << 20;
+    static constexpr size_t kSnapshotBatch = 256;
+
+    // Сущность из двоичной записи; тип выбирается реестром по тегу
+    static Entity* decodeEntity(savefmt::Reader& in, std::pmr::memory_resource* arena) {
+        return EntityRegistry::instance().decode(in.byte(), in, arena);
+    }
+
+    // Сущность зарегистрированного типа из строки текстового сохранения; nullptr — тег неизвестен
+    static Entity* makeFromLine(std::string_view line, std::pmr::memory_resource* arena) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        size_t lastComma = line.rfind(',');
+        if (lastComma == std::string_view::npos) return nullptr;
+        const EntityRegistry::Type* type = EntityRegistry::instance().byTag(line.substr(lastComma + 1));
+        if (!type) return nullptr;
+        Entity* entity = type->make(arena);
+        try {
+            entity->deserialize(std::string(line));
+        } catch (...) {
+            destroyEntity(entity, arena);
+            throw;
+        }
+        return entity;
+    }
+
+    // Строки текстового сохранения в сущности; строки без известного тега пропускаются.
+    // Каждая созданная сущность сразу отдаётся take(entity), который отвечает за неё,
+    // даже если сам бросает исключение.
+    template<typename Take>
+    static void parseLines(std::string_view part, std::pmr::memory_resource* arena, Take&& take) {
+        SaveRecord record;
+        while (!part.empty()) {
+            size_t eol = part.find('\n');
+            std::string_view line = part.substr(0, eol);
+            part = eol == std::string_view::npos ? std::string_view() : part.substr(eol + 1);
+            if (!parseSaveLine(line, record)) {
+                // Типы без быстрого разбора строки — через реестр и deserialize()
+                if (Entity* entity = makeFromLine(line, arena)) take(entity);
+                continue;
+            }
+            if (record.kind == SaveKind::Player) {
+                take(constructEntity<Player>(arena, record.name, record.health, record.level, record.experience));
+            } else {
+                take(constructEntity<Enemy>(arena, record.name, record.health, record.level, record.type));
+            }
+        }
+    }
+
+    // Разбор части в out для последующего adoptLoaded. Место резервируется заранее;
+    // если push_back всё же не удался, сущность уничтожается, а не теряется.
+    static void parseLines(std::string_view part, std::pmr::memory_resource* arena, std::vector<Entity*>& out) {
+        out.reserve(out.size() + part.size() / 24);
+        parseLines(part, arena, [&out, arena](Entity* entity) {
+            try {
+                out.push_back(entity);
+            } catch (...) {
+                destroyEntity(entity, arena);
+                throw;
+            }
+        });
+    }
+
+    std::pmr::memory_resource* newLoadArena() {
+        if (mode == AllocMode::Heap) return nullptr;
+        loadArenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>());
+        return loadArenas.back().get();
+    }
+
+    // Запись сущности в формате сохранения: строка текста или двоичная запись
+    static void writeRecord(const Entity& entity, SaveFormat format, std::string& out) {
+        if (format == SaveFormat::Binary) {
+            entity.encode(out);
+        } else {
+            entity.serializeTo(out);
+            out.push_back('\n');
+        }
+    }
+
+    // Вызывается сущностью перед изменением её полей
+    void beforeChange(Entity& entity) override {
+        if (journalActive && !entity.dirty) {
+            entity.dirty = true;
+            dirtySlots.push_back(entity.slot);
+        }
+        // Копия при записи: старое состояние уходит в снимок один раз за сохранение
+        if (snapshot && entity.snapshotEpoch != snapshotEpoch && !snapshot->done.load(std::memory_order_acquire)) {
+            entity.snapshotEpoch = snapshotEpoch;
+            std::lock_guard<std::mutex> guard(snapshot->lock);
+            if (entity.slot >= snapshot->progress && entity.slot < snapshot->count) {
+                writeRecord(entity, snapshot->format, snapshot->preserved[entity.slot]);
+            }
+        }
+    }
+
+    // Менеджер становится владельцем сущности. Место в векторах резервируется до записи:
+    // если памяти не хватило, сущность уничтожается здесь, а не теряется.
+    void adopt(Entity* entity, bool heap) {
+        try {
+            if (snapshot && !snapshot->done.load(std::memory_order_acquire)) {
+                // Поток записи читает entities под тем же замком; перераспределение вектора только при нём
+                std::lock_guard<std::mutex> guard(snapshot->lock);
+                reserveOneMore(entities);
+            } else {
+                reserveOneMore(entities);
+            }
+            reserveOneMore(heapSlots);
+        } catch (...) {
+            if (heap) {
+                delete entity;
+            } else {
+                entity->~Entity(); // память арены освобождается вместе с ней
+            }
+            throw;
+        }
+        entity->observer = this;
+        entity->slot = static_cast<uint32_t>(entities.size());
+        entity->dirty = false;
+        entity->snapshotEpoch = snapshotEpoch;
+        entities.push_back(entity);
+        heapSlots.push_back(heap);
+        beforeChange(*entity); // новая сущность попадёт в ближайшую дельту
+    }
+
+    // Место ещё под один элемент с обычным геометрическим ростом: следующий push_back не бросает
+    template<typename Vector>
+    static void reserveOneMore(Vector& v) {
+        if (v.size() == v.capacity()) v.reserve(std::max<size_t>(16, v.capacity() * 2));
+    }
+
+    // Запись снимка в поток записи. Пачка из kSnapshotBatch сущностей кодируется под замком,
+    // так что игра ждёт замок не дольше одной пачки. Границы блоков те же, что у saveBinary,
+    // и сжатого сохранения, поэтому файл побайтно совпадает с обычным сохранением того же состояния.
+    void writeSnapshot(Snapshot& snap, std::ostream& out) const {
+        std::string buffer;
+        savefmt::BlockWriter writer(out);
+        savefmt::CompressedWriter packer(out);
+        saveindex::IndexBuilder index;
+        uint64_t flushed = 0;
+        if (snap.format != SaveFormat::Text) {
+            savefmt::putHeader(buffer, snap.format == SaveFormat::Binary ? savefmt::kMagic : savefmt::kCompressedMagic);
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+        std::string& records = snap.format == SaveFormat::Binary       ? writer.payload()
+                               : snap.format == SaveFormat::Compressed ? packer.text()
+                                                                       : buffer;
+        for (size_t begin = 0; begin < snap.count; begin += kSnapshotBatch) {
+            {
+                std::lock_guard<std::mutex> guard(snap.lock);
+                size_t end = std::min(snap.count, begin + kSnapshotBatch);
+                for (size_t i = begin; i < end; ++i) {
+                    size_t start = records.size();
+                    auto saved = snap.preserved.find(static_cast<uint32_t>(i));
+                    if (saved != snap.preserved.end()) {
+                        records += saved->second;
+                        snap.preserved.erase(saved);
+                    } else {
+                        writeRecord(*entities[i], snap.format, records);
+                    }
+                    if (snap.format == SaveFormat::Binary) {
+                        writer.endRecord();
+                    } else if (snap.format == SaveFormat::Compressed) {
+                        packer.endLine();
+                    } else {
+                        index.add(std::string_view(buffer).substr(start, buffer.size() - 1 - start), flushed + start);
+                    }
+                }
+                snap.progress = end;
+            }
+            if (snap.format == SaveFormat::Text && buffer.size() >= kSaveBufferBytes) {
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                flushed += buffer.size();
+                buffer.clear();
+            }
+        }
+        if (snap.format == SaveFormat::Binary) {
+            writer.finish();
+        } else if (snap.format == SaveFormat::Compressed) {
+            packer.finish();
+        } else {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            index.write(out, flushed + buffer.size(), saveindex::kNone);
+        }
+    }
+
+    // Дождаться потока записи снимка; результат и ошибка уже переданы в future
+    void finishSave() {
+        if (saver.joinable()) saver.join();
+        snapshot.reset();
+    }
+
+    Entity* createFrom(const SaveRecord& record) {
+        if (record.kind == SaveKind::Player) {
+            return create<Player>(record.name, record.health, record.level, record.experience);
+        }
+        return create<Enemy>(record.name, record.health, record.level, record.type);
+    }
+
+    // Сущность из кучи удаляется. Сущность арены по одной не разрушается, её память уходит
+    // вместе с ареной; но при учёте времени жизни деструктор вызывается, иначе счётчики
+    // так и останутся ненулевыми и отчёт покажет ложную утечку.
+    void dispose(size_t slot) {
+        if (heapSlots[slot]) {
+            delete entities[slot];
+        } else {
+#if LIFETIME_TRACKING
+            entities[slot]->~Entity();
+#endif
+        }
+    }
+
+    void replace(uint32_t slot, Entity* entity, bool heap) {
+        dispose(slot);
+        entity->observer = this;
+        entity->slot = slot;
+        entity->dirty = false;
+        entities[slot] = entity;
+        heapSlots[slot] = heap;
+        beforeChange(*entity);
+    }
+
+    void startLog(bool truncate) {
+        std::string path = journalBase + ".delta";
+        bool fresh = truncate || !std::filesystem::exists(path);
+        journalLog.open(path, std::ios::binary | (fresh ? std::ios::trunc : std::ios::app));
+        if (!journalLog) {
+            throw std::runtime_error("Failed to open delta log.");
+        }
+        if (fresh) {
+            std::string header;
+            savefmt::putHeader(header, savefmt::kDeltaMagic);
+            journalLog.write(header.data(), static_cast<std::streamsize>(header.size()));
+            journalLog.flush();
+        }
+        journalActive = true;
+    }
+
+    void closeJournal() {
+        journalActive = false;
+        if (journalLog.is_open()) journalLog.close();
+        for (uint32_t slot : dirtySlots) entities[slot]->dirty = false;
+        dirtySlots.clear();
+    }
+
+    // Разбор лога дельт: apply(номер, запись) для каждой записи целых кадров.
+    // Оборванный или испорченный кадр считается концом лога; возвращает длину целой части.
+    template<typename Apply>
+    static size_t replayLog(std::string_view data, Apply apply) {
+        savefmt::Reader in(data);
+        savefmt::readHeader(in, savefmt::kDeltaMagic);
+        size_t validEnd = in.offset();
+        while (!in.atEnd()) {
+            uint64_t count = 0;
+            std::string_view payload;
+            try {
+                savefmt::readBlock(in, count, payload);
+            } catch (const std::runtime_error&) {
+                break;
+            }
+            savefmt::Reader block(payload);
+            for (uint64_t i = 0; i < count; ++i) {
+                uint64_t slot = block.varint();
+                if (slot > 0xFFFFFFFFu) throw std::runtime_error("Invalid entity number in delta log");
+                apply(static_cast<uint32_t>(slot), EntityRegistry::instance().readRecord(block));
+            }
+            validEnd = in.offset();
+        }
+        return validEnd;
+    }
+
+    // Слияние базы и basePath.delta.old в новую базу. Работает только с файлами,
+    // поэтому может идти в фоне, пока игра меняет сущности и пишет новые дельты.
+    static void compactJournal(const std::string& basePath) {
+        std::string oldLog = basePath + ".delta.old";
+        std::string temp = basePath + ".tmp";
+        if (!std::filesystem::exists(oldLog)) return;
+        {
+            MappedFile base(basePath);
+            MappedFile log(oldLog);
+            std::vector<std::string_view> records;
+            savefmt::Reader in(base.view());
+            savefmt::readHeader(in, savefmt::kMagic);
+            while (true) {
+                uint64_t count = 0;
+                std::string_view payload;
+                savefmt::readBlock(in, count, payload);
+                if (count == 0) break;
+                savefmt::Reader block(payload);
+                for (uint64_t i = 0; i < count; ++i) records.push_back(EntityRegistry::instance().readRecord(block));
+            }
+            replayLog(log.view(), [&records](uint32_t slot, std::string_view record) {
+                if (slot < records.size()) {
+                    records[slot] = record;
+                } else if (slot == records.size()) {
+                    records.push_back(record);
+                } else {
+                    throw std::runtime_error("Delta log refers to a missing entity");
+                }
+            });
+
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            std::string header;
+            savefmt::putHeader(header, savefmt::kMagic);
+            out.write(header.data(), static_cast<std::streamsize>(header.size()));
+            savefmt::BlockWriter writer(out);
+            for (std::string_view record : records) {
+                writer.payload().append(record.data(), record.size());
+                writer.endRecord();
+            }
+            writer.finish();
+            out.close();
+            if (!out) {
+                throw std::runtime_error("Failed to write compacted save file.");
+            }
+        }
+        std::filesystem::rename(temp, basePath);
+        std::filesystem::remove(oldLog);
+    }
+
+public:
+    explicit GameManager(AllocMode mode = AllocMode::Heap) : mode(mode) {}
+
+    GameManager(const GameManager&) = delete;
+    GameManager& operator=(const GameManager&) = delete;
+
+    void addEntity(T entity) {
+        adopt(entity, true);
+    }
+
+    // Создаёт сущность в памяти, соответствующей режиму менеджера
+    template<typename E, typename... Args>
+    E* create(Args&&... args) {
+        E* entity = constructEntity<E>(mode == AllocMode::Arena ? &levelPool : nullptr, std::forward<Args>(args)...);
+        adopt(entity, mode == AllocMode::Heap);
+        return entity;
+    }
+
+    // Выгрузка уровня. Сущности арены не разрушаются по одной (см. dispose): вся их память,
+    // включая строки, принадлежит арене и освобождается вместе с ней. Журнал закрывается.
+    void clear() {
+        finishSave();
+        closeJournal();
+        for (size_t i = 0; i < entities.size(); ++i) {
+            dispose(i);
+        }
+        entities.clear();
+        heapSlots.clear();
+        if (mode == AllocMode::Arena) {
+            levelPool.release();
+            levelBuffer.release();
+            loadArenas.clear();
+        }
+    }
+
+    size_t size() const { return entities.size(); }
+
+    void displayAll() const {
+        for (const auto& entity : entities) {
+            entity->display();
+        }
+    }
+
+    void saveToFile(const std::string& filename, SaveFormat format = SaveFormat::Text) const {
+        if (format == SaveFormat::Binary) {
+            saveBinary(filename);
+            return;
+        }
+        if (format == SaveFormat::Compressed) {
+            saveCompressed(filename);
+            return;
+        }
+
+        // Двоичный режим: смещения в индексе считаются в байтах, без перевода '\n' в "\r\n"
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open file for writing.");
+        }
+
+        // Один буфер на всё сохранение, сбрасывается на диск крупными кусками
+        std::string buffer;
+        buffer.reserve(kSaveBufferBytes + 4096);
+        saveindex::IndexBuilder index;
+        uint64_t flushed = 0;
+        for (const auto& entity : entities) {
+            size_t start = buffer.size();
+            entity->serializeTo(buffer);
+            index.add(std::string_view(buffer).substr(start), flushed + start);
+            buffer.push_back('\n');
+            if (buffer.size() >= kSaveBufferBytes) {
+                file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                flushed += buffer.size();
+                buffer.clear();
+            }
+        }
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        index.write(file, flushed + buffer.size(), saveindex::kNone);
+        if (!file) {
+            throw std::runtime_error("Failed to write save file.");
+        }
+    }
+
+    // Дозапись сущностей с номерами от first (например, созданных после прошлого сохранения)
+    // в текстовое сохранение вместе с новым сегментом индекса. Строки, дописанные в файл
+    // без индекса, попадают в этот же сегмент.
+    void appendToFile(const std::string& filename, size_t first) const {
+        saveindex::IndexBuilder index;
+        uint64_t previous = saveindex::kNone;
+        uint64_t size = 0;
+        bool endsWithNewline = true;
+        {
+            MappedFile existing(filename);
+            std::string_view file = existing.view();
+            if (savefmt::isBinary(file) || savefmt::isCompressed(file)) {
+                throw std::runtime_error("Appending is supported for text saves only.");
+            }
+            uint64_t tailStart = 0;
+            previous = saveindex::findLastFooter(file, tailStart);
+            saveindex::forEachTailLine(file, tailStart, [&index](std::string_view line, uint64_t at) {
+                index.add(line, at);
+            });
+            size = file.size();
+            endsWithNewline = file.empty() || file.back() == '\n';
+        }
+
+        std::string buffer;
+        if (!endsWithNewline) buffer.push_back('\n');
+        for (size_t i = first; i < entities.size(); ++i) {
+            size_t start = buffer.size();
+            entities[i]->serializeTo(buffer);
+            index.add(std::string_view(buffer).substr(start), size + start);
+            buffer.push_back('\n');
+        }
+        std::ofstream file(filename, std::ios::binary | std::ios::app);
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        index.write(file, size + buffer.size(), previous);
+        if (!file) {
+            throw std::runtime_error("Failed to write save file.");
+        }
+    }
+
+    // Одна сущность по имени через индекс сохранения, без разбора остальных строк.
+    // Сущность добавляется к уже загруженным; nullptr — в сохранении такой нет.
+    // Если имя встречается несколько раз, берётся последняя запись.
+    Entity* loadEntity(const std::string& filename, std::string_view name) {
+        MappedFile file(filename);
+        if (savefmt::isBinary(file.view()) || savefmt::isCompressed(file.view())) {
+            throw std::runtime_error("Indexed loading is supported for text saves only.");
+        }
+        uint64_t at = saveindex::findByName(file.view(), name);
+        if (at == saveindex::kNone) return nullptr;
+        SaveRecord record;
+        if (!parseSaveLine(saveindex::lineAt(file.view(), at), record)) {
+            throw std::runtime_error("Save index points to a non-entity line");
+        }
+        return createFrom(record);
+    }
+
+    // Все сущности одного вида в порядке файла, добавляются к уже загруженным
+    size_t loadByKind(const std::string& filename, SaveKind kind) {
+        MappedFile file(filename);
+        if (savefmt::isBinary(file.view()) || savefmt::isCompressed(file.view())) {
+            throw std::runtime_error("Indexed loading is supported for text saves only.");
+        }
+        std::vector<uint64_t> offsets = saveindex::findByKind(file.view(), kind);
+        entities.reserve(entities.size() + offsets.size());
+        heapSlots.reserve(heapSlots.size() + offsets.size());
+        SaveRecord record;
+        for (uint64_t at : offsets) {
+            if (!parseSaveLine(saveindex::lineAt(file.view(), at), record) || record.kind != kind) {
+                throw std::runtime_error("Save index points to a wrong line");
+            }
+            createFrom(record);
+        }
+        return offsets.size();
+    }
+
+    // Формат определяется по заголовку файла
+    void loadFromFile(const std::string& filename) {
+        if (savefmt::isBinaryFile(filename)) {
+            loadBinary(savefmt::readFile(filename));
+            return;
+        }
+        if (savefmt::isCompressedFile(filename)) {
+            loadCompressed(savefmt::readFile(filename), 1);
+            return;
+        }
+
+        std::ifstream file(filename);
+        if (!file) {
+            throw std::runtime_error("Failed to open file for reading.");
+        }
+
+        clear();
+
+        // Плохая строка известного типа прерывает загрузку целиком: менеджер остаётся пустым
+        try {
+            std::string line;
+            while (std::getline(file, line)) {
+                size_t lastComma = line.rfind(',');
+                if (lastComma == std::string::npos) {
+                    continue;
+                }
+
+                const EntityRegistry::Type* type =
+                    EntityRegistry::instance().byTag(std::string_view(line).substr(lastComma + 1));
+                if (!type) {
+                    continue;
+                }
+
+                Entity* entity = type->make(mode == AllocMode::Arena ? &levelPool : nullptr);
+                adopt(entity, mode == AllocMode::Heap);
+                entity->deserialize(line);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    // Загрузка через отображение файла в память. Файлы больше kParallelLoadBytes делятся
+    // по границам строк между threads потоками; порядок сущностей сохраняется.
+    // В режиме арены каждый поток пишет в собственный монотонный буфер уровня.
+    void loadFromFileMapped(const std::string& filename, unsigned threads = std::thread::hardware_concurrency()) {
+        MappedFile file(filename);
+        if (savefmt::isBinary(file.view())) {
+            loadBinary(file.view());
+            return;
+        }
+        if (savefmt::isCompressed(file.view())) {
+            loadCompressed(file.view(), threads);
+            return;
+        }
+        clear();
+
+        std::string_view text = file.view();
+        size_t parts = text.size() < kParallelLoadBytes ? 1 : std::max(1u, threads);
+        std::vector<size_t> bounds{0};
+        for (size_t p = 1; p < parts; ++p) {
+            size_t at = text.find('\n', std::max(text.size() * p / parts, bounds.back()));
+            if (at == std::string_view::npos) break;
+            bounds.push_back(at + 1);
+        }
+        bounds.push_back(text.size());
+        size_t chunks = bounds.size() - 1;
+
+        std::vector<std::pmr::memory_resource*> arenas(chunks, nullptr);
+        if (mode == AllocMode::Arena) {
+            for (auto& arena : arenas) {
+                loadArenas.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>());
+                arena = loadArenas.back().get();
+            }
+        }
+
+        std::vector<std::vector<Entity*>> results(chunks);
+        std::vector<std::exception_ptr> errors(chunks);
+        auto work = [&](size_t c) {
+            try {
+                parseLines(text.substr(bounds[c], bounds[c + 1] - bounds[c]), arenas[c], results[c]);
+            } catch (...) {
+                errors[c] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t c = 1; c < chunks; ++c) {
+            workers.emplace_back(work, c);
+        }
+        work(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        adoptLoaded(results, errors);
+    }
+
+    // Сжатое сохранение: заголовки кадров читаются подряд, потом кадры распаковываются и
+    // разбираются в threads потоках; поток берёт следующий свободный кадр, порядок сущностей
+    // сохраняется. В режиме арены у каждого потока свой монотонный буфер.
+    void loadCompressed(std::string_view data, unsigned threads) {
+        clear();
+        std::vector<savefmt::CompressedFrame> frames;
+        savefmt::Reader in(data);
+        savefmt::readHeader(in, savefmt::kCompressedMagic);
+        while (true) {
+            savefmt::CompressedFrame frame = savefmt::readFrame(in);
+            if (frame.lines == 0) break;
+            frames.push_back(frame);
+        }
+
+        size_t workerCount = std::min<size_t>(std::max(1u, threads), std::max<size_t>(1, frames.size()));
+        std::vector<std::pmr::memory_resource*> arenas(workerCount);
+        for (auto& arena : arenas) arena = newLoadArena();
+        std::vector<std::vector<Entity*>> results(frames.size());
+        std::vector<std::exception_ptr> errors(workerCount);
+        std::atomic<size_t> next{0};
+        auto work = [&](size_t w) {
+            try {
+                std::string text;
+                for (size_t f; (f = next.fetch_add(1, std::memory_order_relaxed)) < frames.size();) {
+                    savefmt::unpackFrame(frames[f], text);
+                    parseLines(text, arenas[w], results[f]);
+                }
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t w = 1; w < workerCount; ++w) {
+            workers.emplace_back(work, w);
+        }
+        work(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        adoptLoaded(results, errors);
+    }
+
+    // Сущности, разобранные потоками загрузки, по порядку частей; при любой ошибке менеджер пустеет
+    void adoptLoaded(const std::vector<std::vector<Entity*>>& results, const std::vector<std::exception_ptr>& errors) {
+        size_t total = 0;
+        for (const auto& result : results) total += result.size();
+        entities.reserve(total);
+        heapSlots.reserve(total);
+        for (const auto& result : results) {
+            for (Entity* entity : result) adopt(entity, mode == AllocMode::Heap);
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                clear();
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // Строки сжатого сохранения с номерами [first, first + count) добавляются к загруженным.
+    // Кадры до first пропускаются по заголовкам, распаковываются только те, где есть нужные строки.
+    // Номер строки совпадает с номером сущности, если в файле только известные типы.
+    size_t loadRange(const std::string& filename, size_t first, size_t count) {
+        MappedFile file(filename);
+        savefmt::Reader in(file.view());
+        savefmt::readHeader(in, savefmt::kCompressedMagic);
+        std::pmr::memory_resource* arena = mode == AllocMode::Arena ? &levelPool : nullptr;
+        std::string text;
+        size_t loaded = 0;
+        size_t line = 0;
+        size_t end = first + count;
+        while (line < end) {
+            savefmt::CompressedFrame frame = savefmt::readFrame(in);
+            if (frame.lines == 0) break;
+            if (line + frame.lines <= first) {
+                line += frame.lines;
+                continue;
+            }
+            savefmt::unpackFrame(frame, text);
+            std::string_view part = text;
+            for (; !part.empty() && line < end; ++line) {
+                size_t eol = part.find('\n');
+                std::string_view current = part.substr(0, eol);
+                part = eol == std::string_view::npos ? std::string_view() : part.substr(eol + 1);
+                if (line < first) continue;
+                SaveRecord record;
+                if (parseSaveLine(current, record)) {
+                    createFrom(record);
+                } else if (Entity* entity = makeFromLine(current, arena)) {
+                    adopt(entity, arena == nullptr);
+                } else {
+                    continue;
+                }
+                ++loaded;
+            }
+        }
+        return loaded;
+    }
+
+    // Двоичное сохранение блоками по ~kBlockBytes, каждый со своей CRC
+    void saveBinary(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open file for writing.");
+        }
+
+        std::string header;
+        savefmt::putHeader(header, savefmt::kMagic);
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+        savefmt::BlockWriter writer(file);
+        for (const auto& entity : entities) {
+            entity->encode(writer.payload());
+            writer.endRecord();
+        }
+        writer.finish();
+
+        if (!file) {
+            throw std::runtime_error("Failed to write save file.");
+        }
+    }
+
+    // Сжатое сохранение: строки текстового формата кадрами по ~kCompressedBlockBytes
+    void saveCompressed(const std::string& filename) const {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open file for writing.");
+        }
+
+        std::string header;
+        savefmt::putHeader(header, savefmt::kCompressedMagic);
+        file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+        savefmt::CompressedWriter writer(file);
+        for (const auto& entity : entities) {
+            writeRecord(*entity, SaveFormat::Compressed, writer.text());
+            writer.endLine();
+        }
+        writer.finish();
+
+        if (!file) {
+            throw std::runtime_error("Failed to write save file.");
+        }
+    }
+
+    // Фоновое сохранение снимка текущего состояния. Сам вызов только запускает поток записи;
+    // изменения после вызова в файл не попадают: перед первым изменением сущности её старое
+    // состояние копируется в снимок. Файл пишется во временный и переименовывается целиком.
+    // Предыдущее фоновое сохранение дожидается завершения. Ошибки приходят через future.
+    std::future<void> saveAsync(const std::string& filename, SaveFormat format = SaveFormat::Text) {
+        finishSave();
+        snapshot = std::make_unique<Snapshot>();
+        snapshot->count = entities.size();
+        snapshot->format = format;
+        ++snapshotEpoch;
+
+        std::promise<void> promise;
+        std::future<void> result = promise.get_future();
+        saver = std::thread([this, snap = snapshot.get(), filename, promise = std::move(promise)]() mutable {
+            try {
+                std::string temp = filename + ".tmp";
+                {
+                    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+                    if (!file) {
+                        throw std::runtime_error("Failed to open file for writing.");
+                    }
+                    writeSnapshot(*snap, file);
+                    file.close();
+                    if (!file) {
+                        throw std::runtime_error("Failed to write save file.");
+                    }
+                }
+                std::filesystem::rename(temp, filename);
+                snap->done.store(true, std::memory_order_release);
+                promise.set_value();
+            } catch (...) {
+                snap->done.store(true, std::memory_order_release);
+                promise.set_exception(std::current_exception());
+            }
+        });
+        return result;
+    }
+
+    // Разбор двоичного сохранения; при любой ошибке менеджер остаётся пустым.
+    // Как и при загрузке текста, в режиме арены сущности пишутся в отдельный монотонный буфер.
+    void loadBinary(std::string_view data) {
+        clear();
+        std::pmr::memory_resource* arena = newLoadArena();
+        try {
+            savefmt::Reader reader(data);
+            savefmt::readHeader(reader, savefmt::kMagic);
+            while (true) {
+                uint64_t count = 0;
+                std::string_view payload;
+                savefmt::readBlock(reader, count, payload);
+                if (count == 0) break;
+
+                savefmt::Reader block(payload);
+                for (uint64_t i = 0; i < count; ++i) {
+                    adopt(decodeEntity(block, arena), arena == nullptr);
+                }
+                if (!block.atEnd()) {
+                    throw std::runtime_error("Save file block has trailing data");
+                }
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    // ===== Журнал: база и лог изменений =====
+    // basePath — полное двоичное сохранение, basePath.delta — лог дельт, basePath.delta.old —
+    // лог, который вливается в базу фоновым уплотнением. Запись лога — номер сущности и её полное
+    // состояние, поэтому повторное применение того же лога безвредно (важно после сбоя посреди уплотнения).
+
+    // Полное сохранение в basePath и начало пустого лога; дальше изменения отслеживаются
+    void openJournal(const std::string& basePath) {
+        waitForCompaction();
+        closeJournal();
+        saveBinary(basePath);
+        std::filesystem::remove(basePath + ".delta.old");
+        journalBase = basePath;
+        startLog(true);
+    }
+
+    // Дописывает в лог одним кадром только сущности, изменённые или созданные после прошлого сохранения
+    size_t saveDelta() {
+        if (!journalActive) {
+            throw std::logic_error("Journal is not open");
+        }
+        if (dirtySlots.empty()) return 0;
+
+        savefmt::BlockWriter writer(journalLog, SIZE_MAX);
+        for (uint32_t slot : dirtySlots) {
+            savefmt::putVarint(writer.payload(), slot);
+            entities[slot]->encode(writer.payload());
+            writer.endRecord();
+            entities[slot]->dirty = false;
+        }
+        writer.flush();
+        journalLog.flush();
+        if (!journalLog) {
+            throw std::runtime_error("Failed to write delta log.");
+        }
+        size_t written = dirtySlots.size();
+        dirtySlots.clear();
+        return written;
+    }
+
+    size_t pendingChanges() const { return dirtySlots.size(); }
+
+    // Фоновое уплотнение: лог переименовывается и вливается в новую базу в отдельном потоке,
+    // новые дельты тем временем пишутся в свежий лог. false — предыдущее уплотнение ещё идёт.
+    bool startCompaction() {
+        if (!journalActive) {
+            throw std::logic_error("Journal is not open");
+        }
+        if (compactor.joinable()) {
+            if (!compactionDone.load(std::memory_order_acquire)) return false;
+            waitForCompaction();
+        }
+        journalLog.close();
+        std::filesystem::rename(journalBase + ".delta", journalBase + ".delta.old");
+        startLog(true);
+
+        compactionDone.store(false, std::memory_order_relaxed);
+        compactor = std::thread([this, basePath = journalBase] {
+            try {
+                compactJournal(basePath);
+            } catch (...) {
+                compactionError = std::current_exception();
+            }
+            compactionDone.store(true, std::memory_order_release);
+        });
+        return true;
+    }
+
+    // Дождаться уплотнения; его ошибка пробрасывается здесь
+    void waitForCompaction() {
+        if (compactor.joinable()) compactor.join();
+        if (compactionError) {
+            std::exception_ptr error = compactionError;
+            compactionError = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    // База плюс логи по порядку; оборванный хвост лога отрезается. Незаконченное уплотнение
+    // доводится сразу, после чего журнал открыт и новые дельты дописываются в basePath.delta.
+    void loadJournal(const std::string& basePath) {
+        waitForCompaction();
+        loadFromFileMapped(basePath);
+        try {
+            std::pmr::memory_resource* arena = newLoadArena();
+            for (const std::string& path : {basePath + ".delta.old", basePath + ".delta"}) {
+                if (!std::filesystem::exists(path)) continue;
+                size_t validEnd = 0;
+                {
+                    MappedFile log(path);
+                    validEnd = replayLog(log.view(), [&](uint32_t slot, std::string_view record) {
+                        if (slot > entities.size()) {
+                            throw std::runtime_error("Delta log refers to a missing entity");
+                        }
+                        savefmt::Reader in(record);
+                        Entity* entity = decodeEntity(in, arena);
+                        if (slot < entities.size()) {
+                            replace(slot, entity, arena == nullptr);
+                        } else {
+                            adopt(entity, arena == nullptr);
+                        }
+                    });
+                }
+                if (validEnd < std::filesystem::file_size(path)) {
+                    std::filesystem::resize_file(path, validEnd);
+                }
+            }
+            journalBase = basePath;
+            compactJournal(basePath);
+            startLog(false);
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    ~GameManager() {
+        if (compactor.joinable()) compactor.join();
+        finishSave();
+        clear();
+    }
+};
+
+// Циклы загрузки/выгрузки уровня: new/delete против арены
+void runArenaBenchmark(size_t count, int cycles) {
+    std::cout << "=== Level load/unload, " << count << " entities x " << cycles << " cycles ===" << std::endl;
+    for (AllocMode mode : {AllocMode::Heap, AllocMode::Arena}) {
+        GameManager<Entity*> manager(mode);
+        double loadMs = 0;
+        double unloadMs = 0;
+        size_t checksum = 0;
+        for (int cycle = 0; cycle < cycles; ++cycle) {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; ++i) {
+                std::string name = "Level entity number " + std::to_string(i);
+                if (i % 2 == 0) {
+                    manager.create<Player>(name, 100, 1, static_cast<int>(i));
+                } else {
+                    manager.create<Enemy>(name, 50, 2, "Wandering skeleton archer");
+                }
+            }
+            auto loaded = std::chrono::steady_clock::now();
+            checksum += manager.size();
+            manager.clear();
+            auto unloaded = std::chrono::steady_clock::now();
+            loadMs += std::chrono::duration<double, std::milli>(loaded - start).count();
+            unloadMs += std::chrono::duration<double, std::milli>(unloaded - loaded).count();
+        }
+        std::cout << (mode == AllocMode::Heap ? "heap " : "arena") << ": load " << loadMs / cycles
+                  << " ms, unload " << unloadMs / cycles << " ms per cycle (checksum " << checksum << ")" << std::endl;
+    }
+}
+
+// Загрузка сохранения из count сущностей: getline + substr/stoi против отображения файла
+void runLoadBenchmark(size_t count) {
+    std::cout << "=== Save file load, " << count << " entities ===" << std::endl;
+    const std::string path = "bench_save.txt";
+    {
+        GameManager<Entity*> source(AllocMode::Arena);
+        for (size_t i = 0; i < count; ++i) {
+            std::string name = "Entity" + std::to_string(i);
+            if (i % 2 == 0) {
+                source.create<Player>(name, 100 + static_cast<int>(i % 900), 1 + static_cast<int>(i % 60), static_cast<int>(i));
+            } else {
+                source.create<Enemy>(name, 50 + static_cast<int>(i % 500), 1 + static_cast<int>(i % 80), "Skeleton");
+            }
+        }
+        source.saveToFile(path);
+    }
+    double megabytes = 0;
+    {
+        std::ifstream probe(path, std::ios::binary | std::ios::ate);
+        megabytes = static_cast<double>(probe.tellg()) / (1024.0 * 1024.0);
+    }
+
+    auto measure = [&](const char* label, AllocMode mode, auto load) {
+        GameManager<Entity*> manager(mode);
+        auto start = std::chrono::steady_clock::now();
+        load(manager);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << seconds * 1000 << " ms, " << megabytes / seconds << " MB/s ("
+                  << manager.size() << " entities)" << std::endl;
+    };
+
+    // Только разбор строк, без создания сущностей. Разница с полной загрузкой — создание
+    // сущностей: в основном первое касание ~100 МБ их памяти (ошибки страниц), которое
+    // с несколькими потоками идёт параллельно.
+    {
+        MappedFile file(path);
+        auto start = std::chrono::steady_clock::now();
+        SaveRecord record;
+        size_t parsed = 0;
+        for (std::string_view part = file.view(); !part.empty();) {
+            size_t eol = part.find('\n');
+            parsed += parseSaveLine(part.substr(0, eol), record);
+            part = eol == std::string_view::npos ? std::string_view() : part.substr(eol + 1);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "parse only, 1 thread      : " << seconds * 1000 << " ms, " << megabytes / seconds
+                  << " MB/s (" << parsed << " records)" << std::endl;
+    }
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    measure("getline + stoi, heap      ", AllocMode::Heap, [&](auto& m) { m.loadFromFile(path); });
+    measure("mapped, 1 thread, heap    ", AllocMode::Heap, [&](auto& m) { m.loadFromFileMapped(path, 1); });
+    measure("mapped, 1 thread, arena   ", AllocMode::Arena, [&](auto& m) { m.loadFromFileMapped(path, 1); });
+    measure(("mapped, " + std::to_string(threads) + " threads, heap  ").c_str(), AllocMode::Heap,
+            [&](auto& m) { m.loadFromFileMapped(path, threads); });
+    measure(("mapped, " + std::to_string(threads) + " threads, arena ").c_str(), AllocMode::Arena,
+            [&](auto& m) { m.loadFromFileMapped(path, threads); });
+    std::remove(path.c_str());
+}
+
+// Перевод сохранения между форматами; формат входа определяется по заголовку
+void convertSaveFile(const std::string& from, const std::string& to, SaveFormat format) {
+    GameManager<Entity*> manager(AllocMode::Arena);
+    manager.loadFromFileMapped(from);
+    manager.saveToFile(to, format);
+}
+
+// Текстовый формат против двоичного: время сохранения, размер файла и время загрузки
+void runBinaryBenchmark(size_t count) {
+    std::cout << "=== Text vs binary save, " << count << " entities ===" << std::endl;
+    GameManager<Entity*> source(AllocMode::Arena);
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = "Entity" + std::to_string(i);
+        if (i % 2 == 0) {
+            source.create<Player>(name, 100 + static_cast<int>(i % 900), 1 + static_cast<int>(i % 60), static_cast<int>(i));
+        } else {
+            source.create<Enemy>(name, 50 + static_cast<int>(i % 500), 1 + static_cast<int>(i % 80), "Skeleton");
+        }
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+    auto fileSize = [](const std::string& path) {
+        std::ifstream probe(path, std::ios::binary | std::ios::ate);
+        return static_cast<long long>(probe.tellg());
+    };
+
+    const std::pair<SaveFormat, std::string> formats[] = {{SaveFormat::Text, "bench_save.txt"},
+                                                          {SaveFormat::Binary, "bench_save.bin"}};
+    for (const auto& [format, path] : formats) {
+        const char* label = format == SaveFormat::Text ? "text  " : "binary";
+        auto start = std::chrono::steady_clock::now();
+        source.saveToFile(path, format);
+        double saveMs = ms(start);
+
+        GameManager<Entity*> loaded(AllocMode::Arena);
+        start = std::chrono::steady_clock::now();
+        loaded.loadFromFile(path);
+        double loadMs = ms(start);
+        start = std::chrono::steady_clock::now();
+        loaded.loadFromFileMapped(path, 1);
+        double mappedMs = ms(start);
+
+        std::cout << label << ": " << fileSize(path) << " bytes, save " << saveMs << " ms, load " << loadMs
+                  << " ms, mapped load " << mappedMs << " ms (" << loaded.size() << " entities)" << std::endl;
+        std::remove(path.c_str());
+    }
+}
+
+// Сохранение count сущностей в текст: строка serialize() на каждую сущность против записи в общий буфер
+void runSerializeBenchmark(size_t count) {
+    std::cout << "=== Text save, " << count << " entities ===" << std::endl;
+    GameManager<Entity*> source(AllocMode::Arena);
+    std::vector<const Entity*> all;
+    all.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = "Entity" + std::to_string(i);
+        if (i % 2 == 0) {
+            all.push_back(source.create<Player>(name, 100 + static_cast<int>(i % 900), 1 + static_cast<int>(i % 60),
+                                                static_cast<int>(i)));
+        } else {
+            all.push_back(source.create<Enemy>(name, 50 + static_cast<int>(i % 500), 1 + static_cast<int>(i % 80),
+                                               "Skeleton"));
+        }
+    }
+
+    const std::string path = "bench_save.txt";
+    auto measure = [&](const char* label, auto save) {
+#if COUNT_HEAP_ALLOCATIONS
+        size_t allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+#endif
+        auto start = std::chrono::steady_clock::now();
+        save();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << label << ": " << ms << " ms";
+#if COUNT_HEAP_ALLOCATIONS
+        std::cout << ", " << heapAllocations.load(std::memory_order_relaxed) - allocationsBefore << " heap allocations";
+#endif
+        std::cout << std::endl;
+    };
+
+    measure("serialize() + ostream per entity", [&] {
+        std::ofstream file(path);
+        for (const Entity* entity : all) {
+            file << entity->serialize() << "\n";
+        }
+    });
+    measure("serializeTo + buffered writes   ", [&] { source.saveToFile(path); });
+    std::remove(path.c_str());
+}
+
+// Дельта-сохранения: count сущностей, в каждом раунде меняется changes из них.
+// Сравнение с полным двоичным сохранением, затем фоновое уплотнение и проверка загрузки журнала.
+void runDeltaBenchmark(size_t count) {
+    std::cout << "=== Delta saves, " << count << " entities ===" << std::endl;
+    const std::string base = "bench_journal.bin";
+    GameManager<Entity*> world(AllocMode::Arena);
+    std::vector<Entity*> all;
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = "Entity" + std::to_string(i);
+        if (i % 2 == 0) {
+            all.push_back(world.create<Player>(name, 100, 1, 0));
+        } else {
+            all.push_back(world.create<Enemy>(name, 50, 1, "Skeleton"));
+        }
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    world.openJournal(base);
+    std::cout << "full save (journal base): " << ms(start) << " ms" << std::endl;
+
+    uint64_t seed = 99;
+    auto next = [&seed](size_t bound) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<size_t>((seed >> 33) % bound);
+    };
+    for (size_t changes : {size_t(10), size_t(1000), count / 10, count}) {
+        const int rounds = 5;
+        double total = 0;
+        size_t written = 0;
+        for (int round = 0; round < rounds; ++round) {
+            for (size_t c = 0; c < changes; ++c) {
+                Entity* entity = all[changes == count ? c : next(count)];
+                entity->setHealth(entity->getHealth() + 1);
+                entity->setLevel(entity->getLevel() + 1);
+            }
+            start = std::chrono::steady_clock::now();
+            written += world.saveDelta();
+            total += ms(start);
+        }
+        std::cout << changes << " changed: delta save " << total / rounds << " ms (" << written / rounds
+                  << " entities written)" << std::endl;
+    }
+
+    start = std::chrono::steady_clock::now();
+    world.startCompaction();
+    double startMs = ms(start);
+    for (size_t c = 0; c < 100; ++c) all[next(count)]->setHealth(1);
+    world.saveDelta();
+    world.waitForCompaction();
+    std::cout << "compaction: " << startMs << " ms to start, " << ms(start) << " ms until merged" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    GameManager<Entity*> restored(AllocMode::Arena);
+    restored.loadJournal(base);
+    double loadMs = ms(start);
+    world.saveToFile("bench_expected.bin", SaveFormat::Binary);
+    restored.saveToFile("bench_restored.bin", SaveFormat::Binary);
+    MappedFile expected("bench_expected.bin");
+    MappedFile actual("bench_restored.bin");
+    std::cout << "load base + deltas: " << loadMs << " ms, state "
+              << (expected.view() == actual.view() ? "matches" : "DIFFERS") << std::endl;
+
+    restored.clear();
+    world.clear();
+    for (const char* suffix : {"", ".delta", ".delta.old"}) std::remove((base + suffix).c_str());
+    std::remove("bench_expected.bin");
+    std::remove("bench_restored.bin");
+}
+
+// Фоновое сохранение count сущностей: задержка игрового цикла при обычном сохранении и при
+// saveAsync, пока игра продолжает менять сущности. Файл должен совпасть с состоянием на момент вызова.
+void runAsyncSaveBenchmark(size_t count) {
+    std::cout << "=== Background save, " << count << " entities ===" << std::endl;
+    GameManager<Entity*> world(AllocMode::Arena);
+    std::vector<Entity*> all;
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = "Entity" + std::to_string(i);
+        if (i % 2 == 0) {
+            all.push_back(world.create<Player>(name, 100, 1, 0));
+        } else {
+            all.push_back(world.create<Enemy>(name, 50, 1, "Skeleton"));
+        }
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    world.saveToFile("bench_expected.bin", SaveFormat::Binary);
+    std::cout << "saveToFile (blocking):     " << ms(start) << " ms" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    std::future<void> saved = world.saveAsync("bench_async.bin", SaveFormat::Binary);
+    double stallMs = ms(start);
+
+    // Игровые кадры во время записи: каждый меняет 1000 сущностей и создаёт одну новую
+    size_t frames = 0;
+    double worstFrameMs = 0;
+    for (size_t next = 0; saved.wait_for(std::chrono::seconds(0)) != std::future_status::ready; ++frames) {
+        auto frame = std::chrono::steady_clock::now();
+        for (size_t c = 0; c < 1000; ++c, next = (next + 7919) % count) {
+            all[next]->setHealth(all[next]->getHealth() - 1);
+        }
+        world.create<Enemy>("Spawned", 10, 1, "Slime");
+        worstFrameMs = std::max(worstFrameMs, ms(frame));
+    }
+    saved.get();
+    std::cout << "saveAsync call (stall):    " << stallMs * 1000 << " us, total " << ms(start) << " ms" << std::endl;
+    std::cout << frames << " frames during save, worst frame " << worstFrameMs << " ms" << std::endl;
+
+    MappedFile expected("bench_expected.bin");
+    MappedFile actual("bench_async.bin");
+    std::cout << "snapshot " << (expected.view() == actual.view() ? "matches" : "DIFFERS")
+              << " the state at the call" << std::endl;
+
+    world.clear();
+    std::remove("bench_expected.bin");
+    std::remove("bench_async.bin");
+}
+
+// Загрузка одной сущности и подмножества по виду из большого сохранения:
+// полная загрузка против поиска по встроенному индексу, затем дозапись и поиск в ней
+void runIndexBenchmark(size_t count) {
+    std::cout << "=== Save index, " << count << " entities ===" << std::endl;
+    const std::string path = "bench_index.txt";
+    {
+        GameManager<Entity*> world(AllocMode::Arena);
+        for (size_t i = 0; i < count; ++i) {
+            std::string name = "Entity" + std::to_string(i);
+            if (i % 4 == 0) {
+                world.create<Player>(name, 100, 1, static_cast<int>(i));
+            } else {
+                world.create<Enemy>(name, 50, 1, "Skeleton");
+            }
+        }
+        world.saveToFile(path);
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        GameManager<Entity*> full(AllocMode::Arena);
+        full.loadFromFileMapped(path);
+    }
+    std::cout << "full load:                 " << ms(start) << " ms" << std::endl;
+
+    const int lookups = 1000;
+    GameManager<Entity*> picked(AllocMode::Arena);
+    start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (int i = 0; i < lookups; ++i) {
+        found += picked.loadEntity(path, "Entity" + std::to_string((i * 7919) % count)) != nullptr;
+    }
+    std::cout << "loadEntity by name:        " << ms(start) * 1000 / lookups << " us per entity (" << found << "/"
+              << lookups << " found)" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    size_t players = picked.loadByKind(path, SaveKind::Player);
+    std::cout << "loadByKind(Player):        " << ms(start) << " ms, " << players << " players" << std::endl;
+
+    // Дозапись 1000 новых сущностей и поиск последней из них
+    GameManager<Entity*> added;
+    for (int i = 0; i < 1000; ++i) added.create<Player>("Late" + std::to_string(i), 1, 1, i);
+    start = std::chrono::steady_clock::now();
+    added.appendToFile(path, 0);
+    double appendMs = ms(start);
+    start = std::chrono::steady_clock::now();
+    Entity* late = picked.loadEntity(path, "Late999");
+    std::cout << "append 1000: " << appendMs << " ms, lookup after append " << ms(start) * 1000 << " us ("
+              << (late ? "found" : "NOT FOUND") << ")" << std::endl;
+
+    picked.clear();
+    std::remove(path.c_str());
+}
+
+// Сжатое сохранение против текстового и двоичного: размер, сохранение и загрузка целиком,
+// скорость самого кодека и чтение диапазона строк из середины файла
+void runCompressionBenchmark(size_t count) {
+    std::cout << "=== Compressed save, " << count << " entities ===" << std::endl;
+    GameManager<Entity*> source(AllocMode::Arena);
+    for (size_t i = 0; i < count; ++i) {
+        std::string name = "Entity" + std::to_string(i);
+        if (i % 2 == 0) {
+            source.create<Player>(name, 100 + static_cast<int>(i % 900), 1 + static_cast<int>(i % 60), static_cast<int>(i));
+        } else {
+            source.create<Enemy>(name, 50 + static_cast<int>(i % 500), 1 + static_cast<int>(i % 80), "Skeleton");
+        }
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+    unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+    const std::pair<SaveFormat, std::string> formats[] = {{SaveFormat::Text, "bench_save.txt"},
+                                                          {SaveFormat::Binary, "bench_save.bin"},
+                                                          {SaveFormat::Compressed, "bench_save.lz"}};
+    uintmax_t textBytes = 0;
+    for (const auto& [format, path] : formats) {
+        const char* label = format == SaveFormat::Text ? "text      " : format == SaveFormat::Binary ? "binary    " : "compressed";
+        auto start = std::chrono::steady_clock::now();
+        source.saveToFile(path, format);
+        double saveMs = ms(start);
+        uintmax_t bytes = std::filesystem::file_size(path);
+        if (format == SaveFormat::Text) textBytes = bytes;
+
+        GameManager<Entity*> loaded(AllocMode::Arena);
+        start = std::chrono::steady_clock::now();
+        loaded.loadFromFile(path);
+        double loadMs = ms(start);
+        start = std::chrono::steady_clock::now();
+        loaded.loadFromFileMapped(path, 1);
+        double mappedMs = ms(start);
+        start = std::chrono::steady_clock::now();
+        loaded.loadFromFileMapped(path, threads);
+        double parallelMs = ms(start);
+
+        std::cout << label << ": " << bytes << " bytes (" << static_cast<double>(textBytes) / bytes << "x smaller than text), save "
+                  << saveMs << " ms, load " << loadMs << " ms, mapped " << mappedMs << " ms, mapped x" << threads << " "
+                  << parallelMs << " ms (" << loaded.size() << " entities)" << std::endl;
+    }
+
+    // Кодек отдельно, на тексте сохранения кадрами обычного размера
+    std::string text;
+    {
+        MappedFile file("bench_save.txt");
+        text = std::string(file.view());
+    }
+    std::vector<uint32_t> table;
+    std::string packed;
+    std::vector<size_t> sizes;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t at = 0; at < text.size(); at += savefmt::kCompressedBlockBytes) {
+        size_t before = packed.size();
+        lz::compress(std::string_view(text).substr(at, savefmt::kCompressedBlockBytes), packed, table);
+        sizes.push_back(packed.size() - before);
+    }
+    double compressMs = ms(start);
+    std::string unpacked(text.size(), '\0');
+    start = std::chrono::steady_clock::now();
+    size_t from = 0;
+    for (size_t b = 0; b < sizes.size(); ++b) {
+        size_t at = b * savefmt::kCompressedBlockBytes;
+        lz::decompress(std::string_view(packed).substr(from, sizes[b]), unpacked.data() + at,
+                       std::min(savefmt::kCompressedBlockBytes, text.size() - at));
+        from += sizes[b];
+    }
+    double decompressMs = ms(start);
+    double megabytes = static_cast<double>(text.size()) / (1 << 20);
+    std::cout << "codec: compress " << megabytes / compressMs * 1000 << " MB/s, decompress "
+              << megabytes / decompressMs * 1000 << " MB/s" << (unpacked == text ? "" : " (MISMATCH)") << std::endl;
+
+    // Переход к середине файла по заголовкам кадров
+    GameManager<Entity*> range(AllocMode::Arena);
+    start = std::chrono::steady_clock::now();
+    size_t loaded = range.loadRange("bench_save.lz", count / 2, 100);
+    std::cout << "loadRange(" << count / 2 << ", 100): " << ms(start) << " ms (" << loaded << " entities)" << std::endl;
+
+    for (const auto& [format, path] : formats) std::remove(path.c_str());
+}
+
+// ===== Круговые сохранения: самопроверка и замеры =====
+
+// Случайные сущности: имена разной длины (в том числе пустые и с UTF-8), числа с краевыми
+// значениями int. Запятых и переводов строки в полях нет — их не допускает текстовый формат.
+class EntityGenerator {
+public:
+    explicit EntityGenerator(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    }
+
+    int number() {
+        static const int edges[] = {0, 1, -1, 100, std::numeric_limits<int>::max(), std::numeric_limits<int>::min()};
+        if (next() % 4 == 0) return edges[next() % std::size(edges)];
+        return static_cast<int>(next() % 20001) - 10000;
+    }
+
+    std::string text(size_t maxLength) {
+        static const std::string_view pieces[] = {"a", "Z", "7", " ", "_", "-", "#", "Ж", "дракон", "."};
+        std::string out;
+        for (size_t length = next() % (maxLength + 1); out.size() < length;) {
+            out += pieces[next() % std::size(pieces)];
+        }
+        return out;
+    }
+
+    void fill(GameManager<Entity*>& manager, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (next() % 2 == 0) {
+                manager.create<Player>(text(16), number(), number(), number());
+            } else {
+                manager.create<Enemy>(text(16), number(), number(), text(10));
+            }
+        }
+    }
+
+private:
+    uint64_t state;
+};
+
+// Состояние менеджера для сравнения: двоичное сохранение описывает все поля всех сущностей
+std::string snapshotOf(const GameManager<Entity*>& manager) {
+    const std::string path = "selftest_state.bin";
+    manager.saveToFile(path, SaveFormat::Binary);
+    std::string state;
+    {
+        MappedFile file(path);
+        state = std::string(file.view());
+    }
+    std::remove(path.c_str());
+    return state;
+}
+
+// Порча строки сохранения одной случайной правкой
+std::string mutateLine(std::string line, EntityGenerator& random) {
+    static const std::string_view inserts[] = {",", "-", "9", "x", " ", "\r", "+", "Player", "Enemy", "99999999999"};
+    size_t at = line.empty() ? 0 : random.next() % line.size();
+    switch (random.next() % 6) {
+    case 0:
+        if (!line.empty()) line.erase(at, 1);
+        break;
+    case 1:
+        line.insert(at, inserts[random.next() % std::size(inserts)]);
+        break;
+    case 2:
+        if (!line.empty()) line[at] = "0,-x \r"[random.next() % 6];
+        break;
+    case 3:
+        line.resize(at);
+        break;
+    case 4: {
+        // Замена одного поля целиком
+        std::string_view fields[5];
+        if (!savefmt::splitFields(line, fields, 5)) break;
+        static const std::string_view values[] = {"", "-", "2147483648", "-2147483649", "1e5", " 5", "5 ", "0x10", "Player"};
+        size_t field = random.next() % 5;
+        size_t start = static_cast<size_t>(fields[field].data() - line.data());
+        line.replace(start, fields[field].size(), values[random.next() % std::size(values)]);
+        break;
+    }
+    default:
+        line += "," + line.substr(at);
+        break;
+    }
+    return line;
+}
+
+// Проверки; печатает каждую и возвращает false, если хоть одна не прошла
+bool runSelfTest() {
+    bool passed = true;
+    auto check = [&passed](bool condition, const std::string& what) {
+        std::cout << (condition ? "  ok      " : "  FAILED  ") << what << std::endl;
+        passed = passed && condition;
+    };
+    EntityGenerator random(2024);
+
+    std::cout << "=== Round trip ===" << std::endl;
+    const std::string text = "selftest.txt";
+    const std::string binary = "selftest.bin";
+    const std::string compressed = "selftest.lz";
+    for (size_t count : {size_t(0), size_t(1), size_t(17), size_t(5000), size_t(100000)}) {
+        GameManager<Entity*> source(random.next() % 2 ? AllocMode::Arena : AllocMode::Heap);
+        random.fill(source, count);
+        std::string expected = snapshotOf(source);
+        source.saveToFile(text);
+        source.saveToFile(binary, SaveFormat::Binary);
+        source.saveToFile(compressed, SaveFormat::Compressed);
+
+        for (AllocMode mode : {AllocMode::Heap, AllocMode::Arena}) {
+            std::string suffix = std::to_string(count) + (mode == AllocMode::Heap ? " entities, heap" : " entities, arena");
+            GameManager<Entity*> loaded(mode);
+            loaded.loadFromFile(text);
+            check(snapshotOf(loaded) == expected, "text, getline:       " + suffix);
+            loaded.loadFromFileMapped(text, 1);
+            check(snapshotOf(loaded) == expected, "text, mapped:        " + suffix);
+            loaded.loadFromFileMapped(text, 4);
+            check(snapshotOf(loaded) == expected, "text, mapped x4:     " + suffix);
+            loaded.loadFromFile(binary);
+            check(snapshotOf(loaded) == expected, "binary:              " + suffix);
+            loaded.loadFromFileMapped(binary);
+            check(snapshotOf(loaded) == expected, "binary, mapped:      " + suffix);
+            loaded.loadFromFile(compressed);
+            check(snapshotOf(loaded) == expected, "compressed:          " + suffix);
+            loaded.loadFromFileMapped(compressed, 4);
+            check(snapshotOf(loaded) == expected, "compressed, x4:      " + suffix);
+        }
+        if (count > 0) {
+            // Диапазон из середины совпадает с теми же строками текстового сохранения
+            size_t first = count / 3;
+            size_t length = std::min<size_t>(count - first, 7000);
+            std::string lines;
+            {
+                MappedFile file(text);
+                std::string_view all = file.view();
+                size_t from = 0;
+                for (size_t i = 0; i < first; ++i) from = all.find('\n', from) + 1;
+                size_t to = from;
+                for (size_t i = 0; i < length; ++i) to = all.find('\n', to) + 1;
+                lines = std::string(all.substr(from, to - from));
+            }
+            const std::string slice = "selftest_range.txt";
+            {
+                std::ofstream file(slice, std::ios::binary | std::ios::trunc);
+                file << lines;
+            }
+            GameManager<Entity*> reference;
+            reference.loadFromFile(slice);
+            std::remove(slice.c_str());
+            GameManager<Entity*> part;
+            bool rangeOk = part.loadRange(compressed, first, length) == length;
+            check(rangeOk && snapshotOf(part) == snapshotOf(reference), "compressed, range:   " + std::to_string(count) + " entities");
+        }
+    }
+
+    // Оба разборщика текста: строка либо принята обоими с одинаковым результатом, либо
+    // отвергнута обоими через std::runtime_error, и deserialize() не меняет объект
+    std::cout << "=== Malformed lines ===" << std::endl;
+    const size_t fuzzCount = 50000;
+    size_t accepted = 0;
+    size_t rejected = 0;
+    size_t mismatches = 0;
+    size_t foreignErrors = 0;
+    size_t partialUpdates = 0;
+    Player player("Before", 1, 2, 3);
+    Enemy enemy("Before", 1, 2, "Type");
+    for (size_t i = 0; i < fuzzCount; ++i) {
+        std::string line = random.next() % 2 == 0
+                               ? Player(random.text(12), random.number(), random.number(), random.number()).serialize()
+                               : Enemy(random.text(12), random.number(), random.number(), random.text(8)).serialize();
+        line = mutateLine(line, random);
+
+        bool fastOk = false;
+        bool fastKnown = false;
+        std::string fastResult;
+        try {
+            SaveRecord record;
+            fastKnown = parseSaveLine(line, record);
+            fastOk = fastKnown;
+            if (fastKnown) {
+                fastResult = record.kind == SaveKind::Player
+                                 ? Player(std::string(record.name), record.health, record.level, record.experience).serialize()
+                                 : Enemy(std::string(record.name), record.health, record.level, std::string(record.type)).serialize();
+            }
+        } catch (const std::runtime_error&) {
+            fastKnown = true;
+        } catch (...) {
+            ++foreignErrors;
+        }
+        if (!fastKnown) continue;
+
+        std::string_view stripped = line;
+        if (!stripped.empty() && stripped.back() == '\r') stripped.remove_suffix(1);
+        Entity& target = stripped.size() >= 6 && stripped.substr(stripped.size() - 6) == "Player"
+                             ? static_cast<Entity&>(player)
+                             : static_cast<Entity&>(enemy);
+        std::string before = target.serialize();
+        bool slowOk = false;
+        try {
+            target.deserialize(std::string(stripped));
+            slowOk = true;
+        } catch (const std::runtime_error&) {
+        } catch (...) {
+            ++foreignErrors;
+        }
+
+        if (fastOk != slowOk || (slowOk && target.serialize() != fastResult)) ++mismatches;
+        if (!slowOk && target.serialize() != before) ++partialUpdates;
+        (slowOk ? accepted : rejected) += 1;
+    }
+    check(foreignErrors == 0, "only std::runtime_error escapes the parsers");
+    check(mismatches == 0, "parseSaveLine and deserialize() agree");
+    check(partialUpdates == 0, "rejected lines leave the object unchanged");
+    std::cout << "  " << rejected << " mutated lines rejected, " << accepted << " still valid" << std::endl;
+
+    // Файл с одной испорченной строкой: загрузка либо проходит одинаково обоими путями,
+    // либо падает runtime_error и оставляет менеджер пустым
+    bool filesConsistent = true;
+    for (int round = 0; round < 200; ++round) {
+        GameManager<Entity*> source;
+        random.fill(source, 50);
+        source.saveToFile(text);
+        std::string content;
+        {
+            MappedFile file(text);
+            content = std::string(file.view());
+        }
+        size_t lineStart = content.rfind('\n', random.next() % content.size());
+        lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+        size_t lineEnd = content.find('\n', lineStart);
+        std::string broken = mutateLine(content.substr(lineStart, lineEnd - lineStart), random);
+        std::replace(broken.begin(), broken.end(), '\n', ' ');
+        content.replace(lineStart, lineEnd - lineStart, broken);
+        {
+            std::ofstream file(text, std::ios::binary | std::ios::trunc);
+            file << content;
+        }
+
+        std::string results[2];
+        int index = 0;
+        for (bool mapped : {false, true}) {
+            GameManager<Entity*> loaded;
+            try {
+                if (mapped) loaded.loadFromFileMapped(text); else loaded.loadFromFile(text);
+                results[index] = snapshotOf(loaded);
+            } catch (const std::runtime_error&) {
+                results[index] = "rejected";
+                filesConsistent = filesConsistent && loaded.size() == 0;
+            } catch (...) {
+                filesConsistent = false;
+            }
+            ++index;
+        }
+        filesConsistent = filesConsistent && results[0] == results[1];
+    }
+    check(filesConsistent, "both text loaders agree on a file with one broken line");
+
+    // Двоичный файл с испорченным байтом: только runtime_error, менеджер пуст
+    bool binaryConsistent = true;
+    {
+        GameManager<Entity*> source;
+        random.fill(source, 2000);
+        source.saveToFile(binary, SaveFormat::Binary);
+        std::string content;
+        {
+            MappedFile file(binary);
+            content = std::string(file.view());
+        }
+        for (int round = 0; round < 300; ++round) {
+            std::string broken = content;
+            broken[random.next() % broken.size()] ^= static_cast<char>(1 + random.next() % 255);
+            if (random.next() % 4 == 0) broken.resize(random.next() % broken.size());
+            {
+                std::ofstream file(binary, std::ios::binary | std::ios::trunc);
+                file << broken;
+            }
+            GameManager<Entity*> loaded;
+            try {
+                loaded.loadFromFile(binary);
+            } catch (const std::runtime_error&) {
+                binaryConsistent = binaryConsistent && loaded.size() == 0;
+            } catch (...) {
+                binaryConsistent = false;
+            }
+        }
+    }
+    check(binaryConsistent, "corrupted binary saves fail with runtime_error and leave the manager empty");
+
+    // То же для сжатого: испорченный кадр ловится кодеком или CRC
+    bool compressedConsistent = true;
+    {
+        GameManager<Entity*> source;
+        random.fill(source, 20000);
+        source.saveToFile(compressed, SaveFormat::Compressed);
+        std::string content = savefmt::readFile(compressed);
+        for (int round = 0; round < 300; ++round) {
+            std::string broken = content;
+            broken[random.next() % broken.size()] ^= static_cast<char>(1 + random.next() % 255);
+            if (random.next() % 4 == 0) broken.resize(random.next() % broken.size());
+            {
+                std::ofstream file(compressed, std::ios::binary | std::ios::trunc);
+                file << broken;
+            }
+            GameManager<Entity*> loaded;
+            try {
+                loaded.loadFromFileMapped(compressed, 4);
+                compressedConsistent = compressedConsistent && loaded.size() == 20000;
+            } catch (const std::runtime_error&) {
+                compressedConsistent = compressedConsistent && loaded.size() == 0;
+            } catch (...) {
+                compressedConsistent = false;
+            }
+        }
+    }
+    check(compressedConsistent, "corrupted compressed saves fail with runtime_error and leave the manager empty");
+    std::remove(compressed.c_str());
+
+    std::remove(text.c_str());
+    std::remove(binary.c_str());
+    std::cout << (passed ? "All checks passed" : "SOME CHECKS FAILED") << std::endl;
+    return passed;
+}
+
+// Скорость сохранения и загрузки на случайных наборах разного размера, МБ/с и сущностей/с;
+// в конце — стоимость разбора одной строки, целой и испорченной
+void runRoundTripBenchmark() {
+    std::cout << "=== Round-trip throughput ===" << std::endl;
+    EntityGenerator random(7);
+    const std::string path = "bench_roundtrip";
+    for (size_t count : {size_t(1000), size_t(10000), size_t(100000), size_t(1000000)}) {
+        GameManager<Entity*> source(AllocMode::Arena);
+        random.fill(source, count);
+        for (SaveFormat format : {SaveFormat::Text, SaveFormat::Binary}) {
+            const int repeats = count <= 10000 ? 20 : 3;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) source.saveToFile(path, format);
+            double saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+            double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1 << 20);
+
+            GameManager<Entity*> loaded(AllocMode::Arena);
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; ++r) loaded.loadFromFileMapped(path);
+            double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+            std::cout << count << (format == SaveFormat::Text ? " text  " : " binary") << ": save "
+                      << megabytes / saveSeconds << " MB/s, " << count / saveSeconds << " entities/s; load "
+                      << megabytes / loadSeconds << " MB/s, " << count / loadSeconds << " entities/s" << std::endl;
+        }
+    }
+    std::remove(path.c_str());
+
+    std::vector<std::string> good;
+    std::vector<std::string> bad;
+    for (int i = 0; i < 200000; ++i) {
+        good.push_back(Player(random.text(12), random.number(), random.number(), random.number()).serialize());
+        bad.push_back(mutateLine(good.back(), random));
+    }
+    auto perLine = [](const std::vector<std::string>& lines) {
+        SaveRecord record;
+        size_t parsed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& line : lines) {
+            try {
+                parsed += parseSaveLine(line, record);
+            } catch (const std::runtime_error&) {
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return std::make_pair(ns / lines.size(), parsed);
+    };
+    auto [goodNs, goodParsed] = perLine(good);
+    auto [badNs, badParsed] = perLine(bad);
+    std::cout << "parseSaveLine: valid lines " << goodNs << " ns/line (" << goodParsed << " parsed), mutated lines "
+              << badNs << " ns/line (" << bad.size() - badParsed << " rejected or skipped)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // Перевод сохранения: --convert <откуда> <куда> text|binary|compressed
+    if (argc > 1 && std::strcmp(argv[1], "--convert") == 0) {
+        std::string target = argc > 4 ? argv[4] : "";
+        if (target != "text" && target != "binary" && target != "compressed") {
+            std::cerr << "Usage: " << argv[0] << " --convert <from> <to> text|binary|compressed" << std::endl;
+            return 1;
+        }
+        try {
+            convertSaveFile(argv[2], argv[3], target == "binary"       ? SaveFormat::Binary
+                                              : target == "compressed" ? SaveFormat::Compressed
+                                                                       : SaveFormat::Text);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Самопроверка сохранения и загрузки; код возврата 1 — есть ошибки
+    if (argc > 1 && std::strcmp(argv[1], "--selftest") == 0) {
+        return runSelfTest() ? 0 : 1;
+    }
+
+    // Замеры: --bench [arena|load|binary|serialize|delta|async|index|roundtrip|compress|all]
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+        std::string which = argc > 2 ? argv[2] : "all";
+        if (which == "arena" || which == "all") runArenaBenchmark(1000000, 5);
+        if (which == "load" || which == "all") runLoadBenchmark(1000000);
+        if (which == "binary" || which == "all") runBinaryBenchmark(1000000);
+        if (which == "serialize" || which == "all") runSerializeBenchmark(1000000);
+        if (which == "delta" || which == "all") runDeltaBenchmark(200000);
+        if (which == "async" || which == "all") runAsyncSaveBenchmark(1000000);
+        if (which == "index" || which == "all") runIndexBenchmark(1000000);
+        if (which == "roundtrip" || which == "all") runRoundTripBenchmark();
+        if (which == "compress" || which == "all") runCompressionBenchmark(1000000);
+        return 0;
+    }
+
     try {
         GameManager<Entity*> manager;
         manager.addEntity(new Player("Hero", 100, 1, 0));
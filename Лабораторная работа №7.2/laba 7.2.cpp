@@ -6,50 +6,332 @@
 #include <cstdlib>
 #include <random>
 #include <string>
+#include <deque>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <unordered_set>
+#include <utility>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "../common/lifetime.h"
+#include "../common/game_rng.h"
+#include "../common/name_table.h"
 
 using namespace std;
 
+// ===== Инструментированные блокировки =====
+// При LOCK_STATS=1 каждая именованная блокировка считает захваты, захваты с ожиданием
+// и гистограмму времени ожидания. При LOCK_STATS=0 остаётся обычный mutex без накладных расходов.
+#ifndef LOCK_STATS
+#define LOCK_STATS 0
+#endif
+
+#if LOCK_STATS
+// Статистика одной именованной блокировки (все экземпляры с одинаковым именем суммируются)
+struct LockStats {
+    static constexpr int kBuckets = 40; // корзины по степеням двойки наносекунд
+
+    string name;
+    atomic<uint64_t> acquisitions{0};
+    atomic<uint64_t> contended{0};
+    atomic<uint64_t> totalWaitNs{0};
+    atomic<uint64_t> maxWaitNs{0};
+    atomic<uint64_t> waitHistogram[kBuckets] = {};
+
+    explicit LockStats(const string& name) : name(name) {}
+
+    void recordWait(uint64_t ns) {
+        contended.fetch_add(1, memory_order_relaxed);
+        totalWaitNs.fetch_add(ns, memory_order_relaxed);
+        int bucket = 0;
+        while (bucket + 1 < kBuckets && (uint64_t(1) << (bucket + 1)) <= ns) ++bucket;
+        waitHistogram[bucket].fetch_add(1, memory_order_relaxed);
+        uint64_t prev = maxWaitNs.load(memory_order_relaxed);
+        while (prev < ns && !maxWaitNs.compare_exchange_weak(prev, ns, memory_order_relaxed)) {}
+    }
+
+    // Верхняя граница корзины, в которую попадает доля q ожиданий
+    uint64_t waitPercentileNs(double q) const {
+        uint64_t total = contended.load(memory_order_relaxed);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i) {
+            seen += waitHistogram[i].load(memory_order_relaxed);
+            if (total > 0 && seen >= q * total) return uint64_t(1) << (i + 1);
+        }
+        return 0;
+    }
+};
+
+// Реестр блокировок по именам; живёт до конца программы
+class LockRegistry {
+private:
+    mutex mtx;
+    vector<unique_ptr<LockStats>> locks;
+
+public:
+    static LockRegistry& instance() {
+        static LockRegistry* registry = new LockRegistry(); // не разрушается: потоки могут работать до выхода
+        return *registry;
+    }
+
+    LockStats* get(const string& name) {
+        lock_guard<mutex> lock(mtx);
+        for (auto& stats : locks) {
+            if (stats->name == name) return stats.get();
+        }
+        locks.push_back(make_unique<LockStats>(name));
+        return locks.back().get();
+    }
+
+    void report(ostream& os) {
+        lock_guard<mutex> lock(mtx);
+        vector<LockStats*> sorted;
+        for (auto& stats : locks) sorted.push_back(stats.get());
+        sort(sorted.begin(), sorted.end(), [](LockStats* a, LockStats* b) {
+            return a->totalWaitNs.load() > b->totalWaitNs.load();
+        });
+
+        os << "\n=== Lock contention report ===\n";
+        for (LockStats* s : sorted) {
+            uint64_t acq = s->acquisitions.load();
+            uint64_t cont = s->contended.load();
+            os << s->name << ": " << acq << " acquisitions, " << cont << " contended ("
+               << (acq ? 100.0 * cont / acq : 0.0) << "%), wait total " << s->totalWaitNs.load() / 1e6
+               << " ms, avg " << (cont ? s->totalWaitNs.load() / cont : 0) << " ns, p50 <"
+               << s->waitPercentileNs(0.5) << " ns, p99 <" << s->waitPercentileNs(0.99)
+               << " ns, max " << s->maxWaitNs.load() << " ns\n";
+        }
+    }
+};
+#endif
+
+// Мьютекс с именем; совместим с lock_guard/unique_lock
+class InstrumentedMutex {
+private:
+    mutex m;
+#if LOCK_STATS
+    LockStats* stats;
+#endif
+
+public:
+#if LOCK_STATS
+    InstrumentedMutex(const char* kind, const string& name)
+        : stats(LockRegistry::instance().get(string(kind) + ":" + name)) {}
+#else
+    InstrumentedMutex(const char*, const string&) {}
+#endif
+
+    void lock() {
+#if LOCK_STATS
+        if (!m.try_lock()) {
+            auto start = chrono::steady_clock::now();
+            m.lock();
+            stats->recordWait(uint64_t(chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - start).count()));
+        }
+        stats->acquisitions.fetch_add(1, memory_order_relaxed);
+#else
+        m.lock();
+#endif
+    }
+
+    bool try_lock() {
+        if (!m.try_lock()) return false;
+#if LOCK_STATS
+        stats->acquisitions.fetch_add(1, memory_order_relaxed);
+#endif
+        return true;
+    }
+
+    void unlock() { m.unlock(); }
+};
+
+// Отчёт о блокировках по запросу (при LOCK_STATS=1 также выводится при выходе)
+void dumpLockReport() {
+#if LOCK_STATS
+    LockRegistry::instance().report(cerr);
+#endif
+}
+
+// ===== Консольный вывод из нескольких потоков =====
+// Каждый поток собирает строки в своём буфере, а единственный поток-писатель
+// выводит накопленное целыми кадрами крупными блоками. Строки разных потоков не перемешиваются.
+class ConsoleSink {
+private:
+    mutex mtx;
+    condition_variable hasData;
+    condition_variable drained;
+    string pending;
+    uint64_t submitted = 0;
+    uint64_t written = 0;
+    atomic<bool> quietMode{false};
+    thread writer;
+
+    void writerLoop() {
+        string chunk;
+        unique_lock<mutex> lock(mtx);
+        while (true) {
+            hasData.wait(lock, [this] { return !pending.empty(); });
+            chunk.swap(pending);
+            uint64_t upTo = submitted;
+            lock.unlock();
+
+            fwrite(chunk.data(), 1, chunk.size(), stdout);
+            fflush(stdout);
+            chunk.clear();
+
+            lock.lock();
+            written = upTo;
+            drained.notify_all();
+        }
+    }
+
+    ConsoleSink() : writer([this] { writerLoop(); }) {}
+
+public:
+    static ConsoleSink& instance() {
+        static ConsoleSink* sink = new ConsoleSink(); // не разрушается: писатель работает до выхода
+        return *sink;
+    }
+
+    // Тихий режим: кадры не выводятся. Вызывающий код проверяет ConsoleFrame::enabled()
+    // до того, как собирать аргументы, чтобы не тратить время на имена и числа впустую.
+    void setQuiet(bool quiet) { quietMode = quiet; }
+    bool quiet() const { return quietMode.load(memory_order_relaxed); }
+
+    // Передать готовый кадр писателю; буфер потока очищается, но сохраняет ёмкость
+    void submit(string& frame) {
+        {
+            lock_guard<mutex> lock(mtx);
+            pending.append(frame);
+            ++submitted;
+        }
+        hasData.notify_one();
+        frame.clear();
+    }
+
+    // Дождаться, пока всё отправленное будет выведено
+    void flush() {
+        unique_lock<mutex> lock(mtx);
+        uint64_t target = submitted;
+        drained.wait(lock, [this, target] { return written >= target; });
+    }
+};
+
+// Кадр вывода: всё, что записано в кадр, попадает в консоль одним куском.
+// Вложенные кадры одного потока дописываются во внешний.
+class ConsoleFrame {
+private:
+    bool active;
+
+    static string& buffer() {
+        thread_local string buf;
+        return buf;
+    }
+
+    static int& depth() {
+        thread_local int d = 0;
+        return d;
+    }
+
+public:
+    // Будет ли вывод вообще показан (false в тихом режиме)
+    static bool enabled() { return !ConsoleSink::instance().quiet(); }
+
+    ConsoleFrame() : active(enabled()) { ++depth(); }
+
+    ~ConsoleFrame() {
+        if (--depth() == 0 && !buffer().empty()) {
+            ConsoleSink::instance().submit(buffer());
+        }
+    }
+
+    ConsoleFrame(const ConsoleFrame&) = delete;
+    ConsoleFrame& operator=(const ConsoleFrame&) = delete;
+
+    ConsoleFrame& operator<<(string_view s) {
+        if (active) buffer().append(s);
+        return *this;
+    }
+
+    ConsoleFrame& operator<<(const char* s) {
+        if (active) buffer().append(s);
+        return *this;
+    }
+
+    ConsoleFrame& operator<<(char c) {
+        if (active) buffer().push_back(c);
+        return *this;
+    }
+
+    ConsoleFrame& operator<<(int value) {
+        if (active) {
+            char digits[16];
+            auto res = to_chars(digits, digits + sizeof(digits), value);
+            buffer().append(digits, res.ptr);
+        }
+        return *this;
+    }
+};
+
 // Класс персонажа
 class Character {
 private:
-    string name;
+    NameTable::Id nameId;
     int health;
     int attack;
     int defense;
-    mutex mtx;
+    mutable InstrumentedMutex mtx;
+    LIFETIME_TRACKED(Character)
 
 public:
     Character(const string& name, int health, int attack, int defense)
-        : name(name), health(health), attack(attack), defense(defense) {}
+        : nameId(NameTable::instance().intern(name)), health(health), attack(attack), defense(defense),
+          mtx("Character", name) {}
 
     void takeDamage(int damage) {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         int actualDamage = max(1, damage - defense);
         health -= actualDamage;
         if (health < 0) health = 0;
     }
 
     bool isAlive() const {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         return health > 0;
     }
 
     int getAttack() const {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         return attack;
     }
 
     void displayInfo() const {
-        lock_guard<mutex> lock(mtx);
-        cout << name << " - Health: " << health << ", Attack: " << attack << ", Defense: " << defense << endl;
+        if (!ConsoleFrame::enabled()) return;
+        ConsoleFrame out;
+        lock_guard<InstrumentedMutex> lock(mtx);
+        out << getName() << " - Health: " << health << ", Attack: " << attack << ", Defense: " << defense << "\n";
     }
 
-    string getName() const {
-        return name;
+    string_view getName() const {
+        return NameTable::instance().view(nameId);
+    }
+
+    NameTable::Id getNameId() const {
+        return nameId;
     }
 
     int getHealth() const {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         return health;
     }
 };
@@ -57,116 +339,779 @@ public:
 // Класс монстра
 class Monster {
 private:
-    string name;
+    NameTable::Id nameId;
     int health;
     int attack;
     int defense;
-    mutex mtx;
+    mutable InstrumentedMutex mtx;
+    LIFETIME_TRACKED(Monster)
 
 public:
     Monster(const string& name, int health, int attack, int defense)
-        : name(name), health(health), attack(attack), defense(defense) {}
+        : nameId(NameTable::instance().intern(name)), health(health), attack(attack), defense(defense),
+          mtx("Monster", name) {}
 
     void takeDamage(int damage) {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         int actualDamage = max(1, damage - defense);
         health -= actualDamage;
         if (health < 0) health = 0;
     }
 
     bool isAlive() const {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         return health > 0;
     }
 
     int getAttack() const {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         return attack;
     }
 
     void displayInfo() const {
-        lock_guard<mutex> lock(mtx);
-        cout << name << " - Health: " << health << ", Attack: " << attack << ", Defense: " << defense << endl;
+        if (!ConsoleFrame::enabled()) return;
+        ConsoleFrame out;
+        lock_guard<InstrumentedMutex> lock(mtx);
+        out << getName() << " - Health: " << health << ", Attack: " << attack << ", Defense: " << defense << "\n";
     }
 
-    string getName() const {
-        return name;
+    string_view getName() const {
+        return NameTable::instance().view(nameId);
+    }
+
+    NameTable::Id getNameId() const {
+        return nameId;
     }
 
     int getHealth() const {
-        lock_guard<mutex> lock(mtx);
+        lock_guard<InstrumentedMutex> lock(mtx);
         return health;
     }
 };
 
+// Очередь встреч: двоичная куча монстров по угрозе.
+// Выбор следующего монстра O(1), добавление/удаление/обновление ключа O(log n).
+class EncounterQueue {
+public:
+    using Handle = size_t;
+    using Score = function<int(const Monster&)>; // больше — раньше в бой
+    static constexpr Handle npos = static_cast<Handle>(-1);
+
+    explicit EncounterQueue(Score score) : score(move(score)) {}
+
+    template <typename... Args>
+    Handle emplace(Args&&... args) {
+        Handle h;
+        if (!freeSlots.empty()) {
+            h = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            h = slots.size();
+            slots.emplace_back();
+        }
+        Slot& slot = slots[h];
+        slot.monster = make_unique<Monster>(forward<Args>(args)...);
+        slot.key = score(*slot.monster);
+        slot.seq = nextSeq++;
+        slot.heapPos = heap.size();
+        heap.push_back(h);
+        siftUp(slot.heapPos);
+        return h;
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    // Самый приоритетный монстр
+    Handle top() const { return heap.front(); }
+
+    Monster& get(Handle h) { return *slots[h].monster; }
+
+    // Ключ монстра изменился (например, он получил урон)
+    void update(Handle h) {
+        Slot& slot = slots[h];
+        if (!slot.monster) return;
+        int old = slot.key;
+        slot.key = score(*slot.monster);
+        if (slot.key > old) {
+            siftUp(slot.heapPos);
+        } else if (slot.key < old) {
+            siftDown(slot.heapPos);
+        }
+    }
+
+    // Удаление монстра по дескриптору; дескриптор затем может быть переиспользован
+    void remove(Handle h) {
+        size_t pos = slots[h].heapPos;
+        swapNodes(pos, heap.size() - 1);
+        heap.pop_back();
+        if (pos < heap.size()) {
+            siftUp(pos);
+            siftDown(pos);
+        }
+        slots[h].monster.reset();
+        freeSlots.push_back(h);
+    }
+
+    void pop() { remove(top()); }
+
+    // Смена политики: ключи пересчитываются один раз, куча строится за O(n)
+    void setPolicy(Score newScore) {
+        score = move(newScore);
+        for (Handle h : heap) slots[h].key = score(*slots[h].monster);
+        for (size_t i = heap.size() / 2; i-- > 0;) siftDown(i);
+    }
+
+private:
+    struct Slot {
+        unique_ptr<Monster> monster; // адрес монстра не меняется, пока он в очереди
+        int key = 0;
+        uint64_t seq = 0; // при равной угрозе — в порядке появления
+        size_t heapPos = 0;
+    };
+
+    bool before(size_t a, size_t b) const {
+        const Slot& x = slots[heap[a]];
+        const Slot& y = slots[heap[b]];
+        return x.key != y.key ? x.key > y.key : x.seq < y.seq;
+    }
+
+    void swapNodes(size_t a, size_t b) {
+        swap(heap[a], heap[b]);
+        slots[heap[a]].heapPos = a;
+        slots[heap[b]].heapPos = b;
+    }
+
+    void siftUp(size_t pos) {
+        while (pos > 0) {
+            size_t parent = (pos - 1) / 2;
+            if (!before(pos, parent)) break;
+            swapNodes(pos, parent);
+            pos = parent;
+        }
+    }
+
+    void siftDown(size_t pos) {
+        while (true) {
+            size_t best = pos;
+            size_t left = 2 * pos + 1;
+            size_t right = left + 1;
+            if (left < heap.size() && before(left, best)) best = left;
+            if (right < heap.size() && before(right, best)) best = right;
+            if (best == pos) break;
+            swapNodes(pos, best);
+            pos = best;
+        }
+    }
+
+    Score score;
+    vector<Slot> slots;
+    vector<Handle> freeSlots;
+    vector<Handle> heap;
+    uint64_t nextSeq = 0;
+};
+
+// Готовые политики выбора противника
+namespace EncounterPolicy {
+    int spawnOrder(const Monster&) { return 0; }
+    int strongestAttack(const Monster& m) { return m.getAttack(); }
+    int weakestFirst(const Monster& m) { return -m.getHealth(); }
+
+    // Пустая функция — имя не из списка attack|health|spawn
+    EncounterQueue::Score byName(const string& name) {
+        if (name == "attack") return strongestAttack;
+        if (name == "spawn") return spawnOrder;
+        if (name == "health") return weakestFirst;
+        return nullptr;
+    }
+}
+
 // Глобальные переменные для хранения монстров
-vector<Monster> monsters;
-mutex monstersMutex;
+EncounterQueue encounters(EncounterPolicy::strongestAttack);
+InstrumentedMutex monstersMutex("global", "monstersMutex");
 
 // Функция для генерации случайных монстров
 void generateMonsters() {
-    random_device rd;
-    mt19937 gen(rd());
-    uniform_int_distribution<> healthDist(30, 100);
-    uniform_int_distribution<> attackDist(5, 20);
-    uniform_int_distribution<> defenseDist(1, 10);
+    GameRng gen = makeRngStream();
     vector<string> names = {"Goblin", "Orc", "Troll", "Skeleton", "Zombie", "Dragon"};
 
     while (true) {
         this_thread::sleep_for(chrono::seconds(3)); // Новый монстр каждые 3 секунды
 
-        uniform_int_distribution<> nameDist(0, names.size() - 1);
-        string name = names[nameDist(gen)];
-        int health = healthDist(gen);
-        int attack = attackDist(gen);
-        int defense = defenseDist(gen);
+        const string& name = names[gen.bounded(static_cast<uint32_t>(names.size()))];
+        int health = gen.range(30, 100);
+        int attack = gen.range(5, 20);
+        int defense = gen.range(1, 10);
 
-        lock_guard<mutex> lock(monstersMutex);
-        monsters.emplace_back(name, health, attack, defense);
-        cout << "New monster generated: " << name << " (HP: " << health 
-             << ", ATK: " << attack << ", DEF: " << defense << ")\n";
+        lock_guard<InstrumentedMutex> lock(monstersMutex);
+        encounters.emplace(name, health, attack, defense);
+        if (ConsoleFrame::enabled()) {
+            ConsoleFrame() << "New monster generated: " << name << " (HP: " << health
+                           << ", ATK: " << attack << ", DEF: " << defense << ")\n";
+        }
     }
 }
 
-// Функция для боя между персонажем и монстром
-void battle(Character& hero, Monster& monster) {
-    while (hero.isAlive() && monster.isAlive()) {
-        // Персонаж атакует монстра
-        monster.takeDamage(hero.getAttack());
-        cout << hero.getName() << " attacks " << monster.getName() << "!\n";
-        
-        // Проверяем, жив ли еще монстр
-        if (!monster.isAlive()) {
-            cout << monster.getName() << " has been defeated!\n";
-            break;
-        }
+// Монстр получил урон: обновляем его место в очереди встреч
+void onMonsterDamaged(EncounterQueue::Handle handle) {
+    if (handle == EncounterQueue::npos) return;
+    lock_guard<InstrumentedMutex> lock(monstersMutex);
+    encounters.update(handle);
+}
+
+// Один раунд боя; возвращает false, если монстр пал
+bool fightRound(Character& hero, Monster& monster, EncounterQueue::Handle handle, bool verbose) {
+    // Персонаж атакует монстра
+    monster.takeDamage(hero.getAttack());
+    onMonsterDamaged(handle);
+
+    verbose = verbose && ConsoleFrame::enabled(); // в тихом режиме аргументы вывода не вычисляются
+    ConsoleFrame out; // весь раунд выводится одним кадром
+    if (verbose) out << hero.getName() << " attacks " << monster.getName() << "!\n";
+
+    // Проверяем, жив ли еще монстр
+    if (!monster.isAlive()) {
+        if (verbose) out << monster.getName() << " has been defeated!\n";
+        return false;
+    }
 
-        // Монстр атакует персонажа
-        hero.takeDamage(monster.getAttack());
-        cout << monster.getName() << " attacks " << hero.getName() << "!\n";
+    // Монстр атакует персонажа
+    hero.takeDamage(monster.getAttack());
+    if (verbose) {
+        out << monster.getName() << " attacks " << hero.getName() << "!\n";
 
         // Выводим текущее состояние
         hero.displayInfo();
         monster.displayInfo();
-        cout << "----------------------\n";
+        out << "----------------------\n";
+    }
+    return true;
+}
+
+void announceBattleResult(const Character& hero, const Monster& monster) {
+    if (!ConsoleFrame::enabled()) return;
+    if (hero.isAlive()) {
+        ConsoleFrame() << hero.getName() << " won the battle!\n";
+    } else {
+        ConsoleFrame() << hero.getName() << " has been defeated by " << monster.getName() << "!\n";
+    }
+}
+
+// Функция для боя между персонажем и монстром
+void battle(Character& hero, Monster& monster, EncounterQueue::Handle handle) {
+    while (hero.isAlive() && monster.isAlive()) {
+        if (!fightRound(hero, monster, handle, true)) {
+            break;
+        }
 
         // Пауза между раундами боя
         this_thread::sleep_for(chrono::seconds(1));
     }
 
-    if (hero.isAlive()) {
-        cout << hero.getName() << " won the battle!\n";
-    } else {
-        cout << hero.getName() << " has been defeated by " << monster.getName() << "!\n";
+    announceBattleResult(hero, monster);
+}
+
+// ===== Режим на корутинах C++20 =====
+// Бой и генератор монстров — корутины, которые ждут таймеров через co_await,
+// а не спят в собственном потоке. Тысячи боёв обслуживаются несколькими рабочими потоками.
+
+// Учёт памяти кадров корутин (память одного приостановленного боя)
+struct CoroFrameStats {
+    atomic<size_t> liveBytes{0};
+    atomic<size_t> peakBytes{0};
+    atomic<size_t> liveFrames{0};
+    atomic<size_t> peakFrames{0};
+
+    static void raise(atomic<size_t>& peak, size_t value) {
+        size_t prev = peak.load(memory_order_relaxed);
+        while (prev < value && !peak.compare_exchange_weak(prev, value, memory_order_relaxed)) {}
+    }
+
+    void onAlloc(size_t n) {
+        raise(peakBytes, liveBytes.fetch_add(n, memory_order_relaxed) + n);
+        raise(peakFrames, liveFrames.fetch_add(1, memory_order_relaxed) + 1);
+    }
+
+    void onFree(size_t n) {
+        liveBytes.fetch_sub(n, memory_order_relaxed);
+        liveFrames.fetch_sub(1, memory_order_relaxed);
+    }
+};
+
+CoroFrameStats coroFrameStats;
+
+class CoroScheduler;
+
+// Задача-корутина: ленивая, может ожидаться через co_await или запускаться отдельно через spawn
+class Task {
+public:
+    struct promise_type {
+        coroutine_handle<> continuation;
+        CoroScheduler* owner = nullptr; // задан для задач, запущенных через spawn
+
+        Task get_return_object() { return Task(coroutine_handle<promise_type>::from_promise(*this)); }
+        suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            coroutine_handle<> await_suspend(coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+
+        static void* operator new(size_t n) {
+            coroFrameStats.onAlloc(n);
+            return ::operator new(n);
+        }
+
+        static void operator delete(void* p, size_t n) {
+            coroFrameStats.onFree(n);
+            ::operator delete(p);
+        }
+    };
+
+    explicit Task(coroutine_handle<promise_type> h) : handle(h) {}
+    Task(Task&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    // Ожидание вложенной задачи: управление передаётся ей напрямую (symmetric transfer)
+    bool await_ready() const noexcept { return false; }
+    coroutine_handle<> await_suspend(coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+    void await_resume() const noexcept {}
+
+    coroutine_handle<promise_type> release() { return exchange(handle, nullptr); }
+
+private:
+    coroutine_handle<promise_type> handle;
+};
+
+// Хешированное колесо таймеров: вставка O(1), за тик просматривается один слот
+class TimerWheel {
+public:
+    using Clock = chrono::steady_clock;
+
+    struct Entry {
+        coroutine_handle<> handle;
+        Clock::time_point deadline;
+        uint64_t rounds; // сколько полных оборотов колеса ещё ждать
+    };
+
+    TimerWheel(Clock::duration tick, size_t slotBits)
+        : tick(tick), slotBits(slotBits), slots(size_t(1) << slotBits), start(Clock::now()) {}
+
+    void add(coroutine_handle<> h, Clock::time_point deadline) {
+        uint64_t due = tickOf(deadline);
+        if (due <= currentTick) due = currentTick + 1;
+        uint64_t delta = due - currentTick;
+        slots[due & mask()].push_back({h, deadline, (delta - 1) >> slotBits});
+        ++count;
     }
+
+    // Продвигает колесо до момента now и передаёт сработавшие таймеры в fire
+    template <typename Fire>
+    void advance(Clock::time_point now, Fire&& fire) {
+        uint64_t target = tickOf(now);
+        while (currentTick < target) {
+            ++currentTick;
+            vector<Entry>& slot = slots[currentTick & mask()];
+            size_t kept = 0;
+            for (size_t i = 0; i < slot.size(); ++i) {
+                if (slot[i].rounds == 0) {
+                    fire(slot[i]);
+                    --count;
+                } else {
+                    --slot[i].rounds;
+                    slot[kept++] = slot[i];
+                }
+            }
+            slot.resize(kept);
+        }
+    }
+
+    Clock::time_point nextTickTime() const { return start + tick * (currentTick + 1); }
+    size_t size() const { return count; }
+
+private:
+    uint64_t tickOf(Clock::time_point t) const {
+        if (t <= start) return 0;
+        return uint64_t((t - start + tick - Clock::duration(1)) / tick);
+    }
+
+    size_t mask() const { return slots.size() - 1; }
+
+    Clock::duration tick;
+    size_t slotBits;
+    vector<vector<Entry>> slots;
+    Clock::time_point start;
+    uint64_t currentTick = 0;
+    size_t count = 0;
+};
+
+// Планировщик: пул рабочих потоков, очередь готовых корутин и поток колеса таймеров
+class CoroScheduler {
+public:
+    using Clock = TimerWheel::Clock;
+
+    // Задержка срабатывания таймера относительно заданного дедлайна
+    struct LatencyStats {
+        atomic<uint64_t> samples{0};
+        atomic<uint64_t> totalNs{0};
+        atomic<uint64_t> maxNs{0};
+    };
+
+    explicit CoroScheduler(size_t workerCount, Clock::duration tick = chrono::milliseconds(1))
+        : wheel(tick, 10) {
+        for (size_t i = 0; i < max<size_t>(1, workerCount); ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+        timerThread = thread([this] { timerLoop(); });
+    }
+
+    ~CoroScheduler() {
+        stop();
+        for (auto& worker : workers) worker.join();
+        timerThread.join();
+        // Корутины, не дошедшие до конца (например, бесконечный генератор), уничтожаются здесь
+        for (void* address : roots) {
+            coroutine_handle<>::from_address(address).destroy();
+        }
+    }
+
+    // Запуск задачи без ожидания результата
+    void spawn(Task task) {
+        auto h = task.release();
+        h.promise().owner = this;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            roots.insert(h.address());
+            ++liveTasks;
+        }
+        post(h);
+    }
+
+    void post(coroutine_handle<> h) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            ready.push_back(h);
+        }
+        queueCv.notify_one();
+    }
+
+    struct SleepAwaiter {
+        CoroScheduler& sched;
+        Clock::time_point deadline;
+
+        bool await_ready() const { return Clock::now() >= deadline; }
+
+        void await_suspend(coroutine_handle<> h) {
+            lock_guard<mutex> lock(sched.timerMutex);
+            sched.wheel.add(h, deadline);
+        }
+
+        void await_resume() const { sched.recordLatency(Clock::now() - deadline); }
+    };
+
+    SleepAwaiter sleepFor(Clock::duration d) { return SleepAwaiter{*this, Clock::now() + d}; }
+
+    // Блокирует вызывающий поток, пока все задачи не завершатся или не будет вызван stop()
+    void run() {
+        unique_lock<mutex> lock(stateMutex);
+        idleCv.wait(lock, [this] { return liveTasks == 0 || stopRequested.load(); });
+    }
+
+    void stop() {
+        stopRequested = true;
+        queueCv.notify_all();
+        timerCv.notify_all();
+        idleCv.notify_all();
+    }
+
+    bool stopping() const { return stopRequested.load(); }
+
+    const LatencyStats& latency() const { return latencyStats; }
+
+    void onTaskFinished(coroutine_handle<> h) {
+        lock_guard<mutex> lock(stateMutex);
+        roots.erase(h.address());
+        if (--liveTasks == 0) idleCv.notify_all();
+    }
+
+private:
+    void recordLatency(Clock::duration late) {
+        uint64_t ns = uint64_t(max<int64_t>(0, chrono::duration_cast<chrono::nanoseconds>(late).count()));
+        latencyStats.samples.fetch_add(1, memory_order_relaxed);
+        latencyStats.totalNs.fetch_add(ns, memory_order_relaxed);
+        uint64_t prev = latencyStats.maxNs.load(memory_order_relaxed);
+        while (prev < ns && !latencyStats.maxNs.compare_exchange_weak(prev, ns, memory_order_relaxed)) {}
+    }
+
+    void workerLoop() {
+        while (true) {
+            coroutine_handle<> h;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueCv.wait(lock, [this] { return !ready.empty() || stopRequested.load(); });
+                if (stopRequested) return;
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+    void timerLoop() {
+        vector<coroutine_handle<>> due;
+        while (!stopRequested) {
+            {
+                unique_lock<mutex> lock(timerMutex);
+                timerCv.wait_until(lock, wheel.nextTickTime(), [this] { return stopRequested.load(); });
+                wheel.advance(Clock::now(), [&due](const TimerWheel::Entry& e) { due.push_back(e.handle); });
+            }
+            if (due.empty()) continue;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                ready.insert(ready.end(), due.begin(), due.end());
+            }
+            queueCv.notify_all();
+            due.clear();
+        }
+    }
+
+    TimerWheel wheel;
+    mutex timerMutex;
+    condition_variable timerCv;
+
+    deque<coroutine_handle<>> ready;
+    mutex queueMutex;
+    condition_variable queueCv;
+
+    mutex stateMutex;
+    condition_variable idleCv;
+    unordered_set<void*> roots;
+    size_t liveTasks = 0;
+    atomic<bool> stopRequested{false};
+
+    LatencyStats latencyStats;
+    vector<thread> workers;
+    thread timerThread;
+};
+
+coroutine_handle<> Task::promise_type::FinalAwaiter::await_suspend(coroutine_handle<promise_type> h) noexcept {
+    promise_type& promise = h.promise();
+    if (promise.owner) {
+        // Отдельно запущенная задача сама освобождает свой кадр
+        CoroScheduler* owner = promise.owner;
+        owner->onTaskFinished(h);
+        h.destroy();
+        return noop_coroutine();
+    }
+    return promise.continuation ? promise.continuation : noop_coroutine();
+}
+
+// Генератор монстров в виде корутины
+Task generateMonstersTask(CoroScheduler& sched) {
+    GameRng gen = makeRngStream();
+    vector<string> names = {"Goblin", "Orc", "Troll", "Skeleton", "Zombie", "Dragon"};
+
+    while (!sched.stopping()) {
+        co_await sched.sleepFor(chrono::seconds(3)); // Новый монстр каждые 3 секунды
+
+        const string& name = names[gen.bounded(static_cast<uint32_t>(names.size()))];
+        int health = gen.range(30, 100);
+        int attack = gen.range(5, 20);
+        int defense = gen.range(1, 10);
+
+        lock_guard<InstrumentedMutex> lock(monstersMutex);
+        encounters.emplace(name, health, attack, defense);
+        if (ConsoleFrame::enabled()) {
+            ConsoleFrame() << "New monster generated: " << name << " (HP: " << health
+                           << ", ATK: " << attack << ", DEF: " << defense << ")\n";
+        }
+    }
+}
+
+// Бой в виде корутины: между раундами поток не занят
+Task battleTask(Character& hero, Monster& monster, EncounterQueue::Handle handle, CoroScheduler& sched,
+                chrono::milliseconds roundDelay, bool verbose) {
+    while (hero.isAlive() && monster.isAlive()) {
+        if (!fightRound(hero, monster, handle, verbose)) {
+            break;
+        }
+        co_await sched.sleepFor(roundDelay);
+    }
+
+    if (verbose) announceBattleResult(hero, monster);
+}
+
+// Основной игровой цикл в виде корутины
+Task gameTask(Character& hero, CoroScheduler& sched) {
+    while (hero.isAlive()) {
+        co_await sched.sleepFor(chrono::seconds(1));
+
+        monstersMutex.lock();
+        if (encounters.empty()) {
+            monstersMutex.unlock();
+            ConsoleFrame() << "No monsters to fight. Waiting...\n";
+            continue;
+        }
+        EncounterQueue::Handle target = encounters.top();
+        Monster& currentMonster = encounters.get(target);
+        monstersMutex.unlock();
+
+        if (ConsoleFrame::enabled()) {
+            ConsoleFrame out;
+            out << "\n=== BATTLE START ===\n";
+            out << hero.getName() << " vs " << currentMonster.getName() << "\n";
+            hero.displayInfo();
+            currentMonster.displayInfo();
+            out << "----------------------\n";
+        } // кадр выводится до co_await: после возобновления корутина может быть на другом потоке
+
+        co_await battleTask(hero, currentMonster, target, sched, chrono::seconds(1), true);
+
+        lock_guard<InstrumentedMutex> lock(monstersMutex);
+        if (!currentMonster.isAlive()) {
+            encounters.remove(target);
+        }
+    }
+
+    ConsoleFrame() << "\nGame over!\n";
+    sched.stop();
 }
 
-int main() {
+// Замер: battleCount одновременных боёв на workerCount потоках; verbose — с выводом раундов
+void runCoroutineBenchmark(size_t battleCount, size_t workerCount, bool verbose) {
+    vector<string> names = {"Goblin", "Orc", "Troll", "Skeleton", "Zombie", "Dragon"};
+    deque<Character> heroes;
+    deque<Monster> foes;
+    for (size_t i = 0; i < battleCount; ++i) {
+        heroes.emplace_back("Hero", 100, 15, 5);
+        foes.emplace_back(names[i % names.size()], 30 + int(i % 71), 5 + int(i % 16), 1 + int(i % 10));
+    }
+
+    auto started = chrono::steady_clock::now();
+    {
+        CoroScheduler sched(workerCount);
+        for (size_t i = 0; i < battleCount; ++i) {
+            sched.spawn(battleTask(heroes[i], foes[i], EncounterQueue::npos, sched, chrono::milliseconds(10), verbose));
+        }
+        sched.run();
+        ConsoleSink::instance().flush();
+
+        auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        const auto& lat = sched.latency();
+        uint64_t samples = max<uint64_t>(1, lat.samples.load());
+        size_t peakFrames = max<size_t>(1, coroFrameStats.peakFrames.load());
+
+        size_t heroWins = 0;
+        for (const auto& hero : heroes) heroWins += hero.isAlive();
+
+        cerr << "Battles: " << battleCount << " on " << workerCount << " worker thread(s)"
+             << (verbose ? (ConsoleSink::instance().quiet() ? ", output formatting skipped (--quiet)" : ", with output") : "")
+             << "\n"
+             << "Hero wins: " << heroWins << "\n"
+             << "Elapsed: " << elapsed << " s\n"
+             << "Peak suspended frames: " << coroFrameStats.peakFrames.load() << "\n"
+             << "Coroutine frame per battle: " << coroFrameStats.peakBytes.load() / peakFrames << " bytes"
+             << " (+ " << sizeof(Character) + sizeof(Monster) << " bytes of Character/Monster state)\n"
+             << "Timer dispatch latency: avg " << lat.totalNs.load() / samples / 1000.0
+             << " us, max " << lat.maxNs.load() / 1000.0 << " us over " << lat.samples.load() << " wakeups\n";
+    }
+}
+
+// Неотрицательное целое из аргумента командной строки; false, если аргумент не число
+bool parseNumber(const char* text, uint64_t& value) {
+    const char* end = text + char_traits<char>::length(text);
+    uint64_t parsed = 0;
+    auto res = from_chars(text, end, parsed);
+    if (res.ec != errc() || res.ptr != end || res.ptr == text) return false;
+    value = parsed;
+    return true;
+}
+
+int printUsage(const char* program) {
+    cerr << "Usage: " << program << " [--coro | --coro-bench [battles] [workers] [--print]]"
+         << " [--seed N] [--policy attack|health|spawn] [--quiet]\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    // Режим: без ключа — игра на потоках, --coro — игра на корутинах,
+    // --coro-bench [боёв] [потоков] — замер корутинного режима.
+    // --seed N делает появление монстров воспроизводимым
+    // --policy attack|health|spawn: порядок, в котором герой выбирает противников
+    // --quiet: вывод игры не форматируется вовсе; --print: замер с выводом раундов
+    // Режим и ключи разбираются за один проход и могут идти в любом порядке.
+    string mode;
+    vector<uint64_t> counts;
+    uint64_t seed = random_device{}();
+    bool hasPrint = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        uint64_t number = 0;
+        if (arg == "--coro" || arg == "--coro-bench") {
+            if (!mode.empty()) return printUsage(argv[0]);
+            mode = arg;
+        } else if (arg == "--quiet") {
+            ConsoleSink::instance().setQuiet(true);
+        } else if (arg == "--print") {
+            hasPrint = true;
+        } else if (arg == "--seed") {
+            if (i + 1 >= argc || !parseNumber(argv[++i], seed)) return printUsage(argv[0]);
+        } else if (arg == "--policy") {
+            EncounterQueue::Score policy = i + 1 < argc ? EncounterPolicy::byName(argv[++i]) : nullptr;
+            if (!policy) return printUsage(argv[0]);
+            encounters.setPolicy(move(policy));
+        } else if (mode == "--coro-bench" && counts.size() < 2 && parseNumber(argv[i], number)) {
+            counts.push_back(number);
+        } else {
+            cerr << "Unknown argument: " << arg << "\n";
+            return printUsage(argv[0]);
+        }
+    }
+    setMasterSeed(seed);
+
+#if LOCK_STATS
+    atexit(dumpLockReport);
+#endif
+
+    // Замер корутинного режима: laba --coro-bench [боёв] [потоков] [--print]
+    if (mode == "--coro-bench") {
+        size_t battles = counts.size() > 0 ? size_t(counts[0]) : 100000;
+        size_t workers = counts.size() > 1 ? size_t(max<uint64_t>(1, counts[1])) : max(1u, thread::hardware_concurrency());
+        runCoroutineBenchmark(battles, workers, hasPrint);
+        return 0;
+    }
+
     // Создаем персонажа
     Character hero("Hero", 100, 15, 5);
-    cout << "Hero created:\n";
-    hero.displayInfo();
-    cout << endl;
+    if (ConsoleFrame::enabled()) {
+        ConsoleFrame out;
+        out << "Hero created:\n";
+        hero.displayInfo();
+        out << "\n";
+    }
+
+    // Игра на корутинах: laba --coro
+    if (mode == "--coro") {
+        CoroScheduler sched(2);
+        sched.spawn(generateMonstersTask(sched));
+        sched.spawn(gameTask(hero, sched));
+        sched.run();
+        ConsoleSink::instance().flush();
+        return 0;
+    }
 
     // Запускаем генератор монстров в отдельном потоке
     thread monsterGenerator(generateMonsters);
@@ -178,25 +1123,29 @@ int main() {
 
         // Проверяем наличие монстров
         monstersMutex.lock();
-        if (!monsters.empty()) {
-            // Берем первого монстра из списка
-            Monster& currentMonster = monsters.front();
+        if (!encounters.empty()) {
+            // Берем самого приоритетного монстра из очереди встреч
+            EncounterQueue::Handle target = encounters.top();
+            Monster& currentMonster = encounters.get(target);
             monstersMutex.unlock();
 
-            cout << "\n=== BATTLE START ===\n";
-            cout << hero.getName() << " vs " << currentMonster.getName() << "\n";
-            hero.displayInfo();
-            currentMonster.displayInfo();
-            cout << "----------------------\n";
+            if (ConsoleFrame::enabled()) {
+                ConsoleFrame out;
+                out << "\n=== BATTLE START ===\n";
+                out << hero.getName() << " vs " << currentMonster.getName() << "\n";
+                hero.displayInfo();
+                currentMonster.displayInfo();
+                out << "----------------------\n";
+            }
 
             // Запускаем бой в отдельном потоке
-            thread fight(battle, ref(hero), ref(currentMonster));
+            thread fight(battle, ref(hero), ref(currentMonster), target);
             fight.join();
 
             // Удаляем побежденного монстра
             monstersMutex.lock();
-            if (!monsters.empty() && !monsters.front().isAlive()) {
-                monsters.erase(monsters.begin());
+            if (!currentMonster.isAlive()) {
+                encounters.remove(target);
             }
             monstersMutex.unlock();
 
@@ -205,10 +1154,11 @@ int main() {
             }
         } else {
             monstersMutex.unlock();
-            cout << "No monsters to fight. Waiting...\n";
+            ConsoleFrame() << "No monsters to fight. Waiting...\n";
         }
     }
 
-    cout << "\nGame over!\n";
+    ConsoleFrame() << "\nGame over!\n";
+    ConsoleSink::instance().flush();
     return 0;
 }
\ No newline at end of file
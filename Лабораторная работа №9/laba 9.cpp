@@ -3,26 +3,139 @@
 #include <vector>
 #include <fstream>
 #include <stdexcept>
+#include <sstream>
+#include <string_view>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <charconv>
+
+#include "../common/lifetime.h"
+#include "../common/lz_frames.h"
+
+// ===== Чтение сжатых файлов =====
+// Формат кадров — common/lz_frames.h (общий с лабораторной 7.1). Здесь распаковка
+// нескольких кадров сразу и чтение хвоста журнала.
+namespace lzfile {
+
+// Текст кадров [first, frames.size()): место каждого кадра в результате известно по заголовкам,
+// поэтому кадры распаковываются параллельно, каждый поток — свою часть
+inline std::string unpack(const std::vector<Frame>& frames, size_t first = 0) {
+    std::vector<size_t> starts{0};
+    for (size_t f = first; f < frames.size(); ++f) starts.push_back(starts.back() + frames[f].size);
+    std::string text(starts.back(), '\0');
+    size_t count = frames.size() - first;
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count);
+    std::vector<std::exception_ptr> errors(std::max<size_t>(threads, 1));
+    auto work = [&](size_t t) {
+        try {
+            for (size_t f = t; f < count; f += threads) unpackFrame(frames[first + f], text.data() + starts[f]);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t) workers.emplace_back(work, t);
+    if (threads > 0) work(0);
+    for (auto& worker : workers) worker.join();
+    for (const auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    return text;
+}
+
+inline std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open file " + filename);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Последние count строк сжатого файла: распаковываются только кадры с конца, где они лежат
+inline std::string tail(const std::string& filename, size_t count) {
+    std::string file = readFile(filename);
+    std::vector<Frame> frames = readContents(file).frames;
+    size_t first = frames.size();
+    uint64_t lines = 0;
+    while (first > 0 && lines < count) lines += frames[--first].lines;
+    std::string text = unpack(frames, first);
+    size_t start = text.size();
+    for (uint64_t skip = std::min<uint64_t>(count, lines); skip > 0 && start > 0; --skip) {
+        start = start >= 2 ? text.rfind('\n', start - 2) : std::string::npos;
+        start = start == std::string::npos ? 0 : start + 1;
+    }
+    return text.substr(start);
+}
+
+}  // namespace lzfile
 
 
+// Журнал игры. В сжатом режиме сообщения копятся в памяти и дописываются в файл кадрами
+// lzfile по ~kFrameBytes; при закрытии журнала — остаток и завершающий кадр
 template <typename T>
 class Logger {
 private:
     std::ofstream logFile;
+    bool compressed;
+    std::ostringstream pending;
+    size_t pendingLines = 0;
+
+    void flushFrame() {
+        if (pendingLines == 0) return;
+        lzfile::writeFrame(logFile, pending.str(), pendingLines);
+        logFile.flush();
+        pending.str("");
+        pendingLines = 0;
+    }
+
 public:
-    Logger(const std::string& filename) {
-        logFile.open(filename, std::ios::app);
+    Logger(const std::string& filename, bool compressed = false) : compressed(compressed) {
+        bool fresh = true;
+        if (compressed && std::filesystem::exists(filename)) {
+            // Дозапись начинается сразу за последним целым кадром: завершающий кадр прошлого
+            // сеанса и кадр, оборванный сбоем, отрезаются, иначе новые кадры за ними не прочитать.
+            // Обрывок одного заголовка файла равносилен пустому файлу.
+            std::string existing = lzfile::readFile(filename);
+            std::string_view magic(lzfile::kMagic, sizeof(lzfile::kMagic));
+            if (existing.size() < lzfile::kHeaderBytes && magic.substr(0, existing.size()) == existing) {
+                std::filesystem::resize_file(filename, 0);
+            } else {
+                std::filesystem::resize_file(filename, lzfile::readContents(existing).dataEnd);
+                fresh = false;
+            }
+        }
+        logFile.open(filename, compressed ? std::ios::app | std::ios::binary : std::ios::app);
         if (!logFile.is_open()) {
             throw std::runtime_error("Unable to open log file");
         }
+        if (compressed && fresh) {
+            lzfile::writeHeader(logFile);
+        }
     }
     ~Logger() {
         if (logFile.is_open()) {
+            flushFrame();
+            if (compressed) lzfile::writeEndFrame(logFile);
             logFile.close();
         }
     }
     void log(const T& message) {
-        logFile << message << std::endl;
+        if (!compressed) {
+            logFile << message << std::endl;
+            return;
+        }
+        pending << message << '\n';
+        ++pendingLines;
+        if (static_cast<size_t>(pending.tellp()) >= lzfile::kFrameBytes) {
+            flushFrame();
+        }
     }
 };
 
@@ -35,6 +148,7 @@ private:
     int defense;
     int level;
     int experience;
+    LIFETIME_TRACKED(Character)
 
 public:
     Character(const std::string& n, int h, int a, int d)
@@ -123,6 +237,7 @@ protected:
     int health;
     int attack;
     int defense;
+    LIFETIME_TRACKED(Monster)
 
 public:
     Monster(const std::string& n, int h, int a, int d)
@@ -191,6 +306,7 @@ public:
 class Inventory {
 private:
     std::vector<std::string> items;
+    LIFETIME_TRACKED(Inventory)
 
 public:
     void addItem(const std::string& item) {
@@ -223,10 +339,13 @@ private:
     Character player;
     Inventory inventory;
     Logger<std::string> logger;
+    bool compressed;
 
 public:
-    Game(const std::string& playerName)
-        : player(playerName, 100, 20, 10), logger("game_log.txt") {}
+    // compressed: журнал в game_log.lz и сохранения в сжатом виде (см. lzfile)
+    Game(const std::string& playerName, bool compressed = false)
+        : player(playerName, 100, 20, 10), logger(compressed ? "game_log.lz" : "game_log.txt", compressed),
+          compressed(compressed) {}
 
     void start() {
         std::cout << "Добро пожаловать в RPG игру Dota 3, " << player.getName() << "!" << std::endl;
@@ -275,26 +394,46 @@ public:
     }
 
     void saveGame(const std::string& filename) {
-        std::ofstream saveFile(filename);
+        std::ofstream saveFile(filename, compressed ? std::ios::out | std::ios::binary : std::ios::out);
         if (!saveFile) {
         std::cout << "Не удалось открыть файл сохранения." << std::endl;
         return;
         }
-        saveFile << player.getName() << std::endl;
-        saveFile << player.getHealth() << std::endl;
-        saveFile << player.getAttack() << std::endl;
-        saveFile << player.getDefense() << std::endl;
-        saveFile << player.getLevel() << std::endl;
-        saveFile << player.getExperience() << std::endl;
+        std::ostringstream content;
+        content << player.getName() << std::endl;
+        content << player.getHealth() << std::endl;
+        content << player.getAttack() << std::endl;
+        content << player.getDefense() << std::endl;
+        content << player.getLevel() << std::endl;
+        content << player.getExperience() << std::endl;
+        if (compressed) {
+            lzfile::writeHeader(saveFile);
+            lzfile::writeFrame(saveFile, content.str(), 6);
+            lzfile::writeEndFrame(saveFile);
+        } else {
+            saveFile << content.str();
+        }
         std::cout << "Игра сохранена в " << filename << std::endl;
     }
 
+    // Сжатое сохранение узнаётся по заголовку, поэтому загрузка не зависит от режима игры
     void loadGame(const std::string& filename) {
-        std::ifstream loadFile(filename);
-        if (!loadFile) {
+        std::ifstream saveFile(filename, std::ios::binary);
+        if (!saveFile) {
         std::cout << "Не удалось открыть файл сохранения." << std::endl;
         return;
         }
+        std::ostringstream content;
+        content << saveFile.rdbuf();
+        std::istringstream loadFile(content.str());
+        if (lzfile::hasHeader(content.str())) {
+            try {
+                loadFile.str(lzfile::unpack(lzfile::readContents(content.str()).frames));
+            } catch (const std::exception& e) {
+            std::cout << "Файл сохранения повреждён: " << e.what() << std::endl;
+            return;
+            }
+        }
         std::string name;
         int health, attack, defense, level, experience;
         loadFile >> name >> health >> attack >> defense >> level >> experience;
@@ -329,9 +468,94 @@ public:
     }
 };
 
-int main() {
+// Журнал из count сообщений боя: обычный текст против сжатого. Размер, время записи
+// и время чтения целиком (getline против параллельной распаковки кадров).
+void runLogBenchmark(size_t count) {
+    const std::string monsters[] = {"Троль", "Огр", "Дракон"};
+    auto ms = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+    uintmax_t plainBytes = 0;
+    for (bool compressed : {false, true}) {
+        const std::string path = compressed ? "bench_log.lz" : "bench_log.txt";
+        std::remove(path.c_str());
+        auto start = std::chrono::steady_clock::now();
+        {
+            Logger<std::string> logger(path, compressed);
+            for (size_t i = 0; i < count; ++i) {
+                const std::string& monster = monsters[i % 3];
+                logger.log(i % 4 == 0 ? monster + " attacks Hero, but it has no effect!"
+                                      : "Hero attacks " + monster + " for " + std::to_string(10 + i % 15) + " damage!");
+            }
+        }
+        double writeMs = ms(start);
+        uintmax_t bytes = std::filesystem::file_size(path);
+        if (!compressed) plainBytes = bytes;
+
+        start = std::chrono::steady_clock::now();
+        size_t lines = 0;
+        if (compressed) {
+            std::string text = lzfile::unpack(lzfile::readContents(lzfile::readFile(path)).frames);
+            lines = static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+        } else {
+            std::ifstream file(path);
+            for (std::string line; std::getline(file, line);) ++lines;
+        }
+        double readMs = ms(start);
+
+        std::cout << (compressed ? "compressed: " : "plain:      ") << bytes << " bytes ("
+                  << static_cast<double>(plainBytes) / bytes << "x), write " << writeMs << " ms, read " << readMs
+                  << " ms (" << lines << " lines)" << std::endl;
+        std::remove(path.c_str());
+    }
+}
+
+// Число целиком, без знака и хвоста; false — строка не число или не помещается в size_t
+bool parseNumber(const char* text, size_t& value) {
+    const char* end = text + std::char_traits<char>::length(text);
+    size_t parsed = 0;
+    auto res = std::from_chars(text, end, parsed);
+    if (res.ec != std::errc() || res.ptr != end || res.ptr == text) return false;
+    value = parsed;
+    return true;
+}
+
+int printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--compress | --bench [messages] | --log <file> [lines]]\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    // Замер журнала: --bench [число сообщений]
+    if (mode == "--bench") {
+        size_t count = 1000000;
+        if (argc > 3 || (argc > 2 && (!parseNumber(argv[2], count) || count == 0))) return printUsage(argv[0]);
+        runLogBenchmark(count);
+        return 0;
+    }
+
+    // Чтение сжатого журнала: --log <файл> [последние N строк]
+    if (mode == "--log") {
+        size_t lines = 0;
+        if (argc < 3 || argc > 4 || (argc > 3 && !parseNumber(argv[3], lines))) return printUsage(argv[0]);
+        try {
+            if (argc > 3) {
+                std::cout << lzfile::tail(argv[2], lines);
+            } else {
+                std::cout << lzfile::unpack(lzfile::readContents(lzfile::readFile(argv[2])).frames);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     try {
-        Game game("Hero");
+        // --compress: сжатые журнал и сохранения
+        Game game("Hero", mode == "--compress");
         game.start();
 
         bool running = true;